@@ -0,0 +1,52 @@
+#include "extension.h"
+
+/**
+ * @brief Traffic counters of one client connection, updated from any thread.
+ *
+ * Bytes are counted as they go over the wire, after compression.
+ */
+class ConnectionStats
+{
+public:
+	void OnReceived(size_t wireSize)
+	{
+		m_messagesIn.fetch_add(1, std::memory_order_relaxed);
+		m_bytesIn.fetch_add(wireSize, std::memory_order_relaxed);
+	}
+
+	void OnSent(const ix::WebSocketSendInfo &info)
+	{
+		if (!info.success)
+		{
+			return;
+		}
+
+		m_messagesOut.fetch_add(1, std::memory_order_relaxed);
+		m_bytesOut.fetch_add(info.wireSize, std::memory_order_relaxed);
+	}
+
+	void OnOpen()
+	{
+		m_connects.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	uint64_t GetMessagesIn() const { return m_messagesIn.load(std::memory_order_relaxed); }
+	uint64_t GetBytesIn() const { return m_bytesIn.load(std::memory_order_relaxed); }
+	uint64_t GetMessagesOut() const { return m_messagesOut.load(std::memory_order_relaxed); }
+	uint64_t GetBytesOut() const { return m_bytesOut.load(std::memory_order_relaxed); }
+
+	/**
+	 * @brief Connections opened after the first one.
+	 */
+	uint64_t GetReconnects() const {
+		uint64_t connects = m_connects.load(std::memory_order_relaxed);
+		return connects ? connects - 1 : 0;
+	}
+
+private:
+	std::atomic<uint64_t> m_messagesIn{0};
+	std::atomic<uint64_t> m_bytesIn{0};
+	std::atomic<uint64_t> m_messagesOut{0};
+	std::atomic<uint64_t> m_bytesOut{0};
+	std::atomic<uint64_t> m_connects{0};
+};
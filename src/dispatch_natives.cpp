@@ -0,0 +1,255 @@
+#include "extension.h"
+
+static cell_t dispatch_SetFrameBudget(IPluginContext *pContext, const cell_t *params)
+{
+	if (params[1] < 0)
+	{
+		pContext->ReportError("Invalid frame budget %d", params[1]);
+		return 0;
+	}
+
+	if (params[2] < 1)
+	{
+		pContext->ReportError("Invalid minimum task count %d", params[2]);
+		return 0;
+	}
+
+	g_TaskDispatcher.SetBudget(params[1], params[2], params[3]);
+
+	return 1;
+}
+
+static cell_t dispatch_GetFrameBudget(IPluginContext *pContext, const cell_t *params)
+{
+	return g_TaskDispatcher.GetBudget();
+}
+
+static cell_t dispatch_GetMinTasks(IPluginContext *pContext, const cell_t *params)
+{
+	return g_TaskDispatcher.GetMinTasks();
+}
+
+static cell_t dispatch_GetAdaptive(IPluginContext *pContext, const cell_t *params)
+{
+	return g_TaskDispatcher.IsAdaptive();
+}
+
+static bool IsValidLane(IPluginContext *pContext, cell_t lane)
+{
+	if (lane < 0 || lane >= TaskLane_Count)
+	{
+		pContext->ReportError("Invalid task lane %d", lane);
+		return false;
+	}
+
+	return true;
+}
+
+static cell_t dispatch_GetPendingTasks(IPluginContext *pContext, const cell_t *params)
+{
+	if (params[0] >= 1 && params[1] != -1)
+	{
+		if (!IsValidLane(pContext, params[1]))
+		{
+			return 0;
+		}
+
+		return static_cast<cell_t>(g_TaskDispatcher.GetPending(static_cast<TaskLane>(params[1])));
+	}
+
+	return static_cast<cell_t>(g_TaskDispatcher.GetPending());
+}
+
+static cell_t dispatch_SetLaneWeight(IPluginContext *pContext, const cell_t *params)
+{
+	if (!IsValidLane(pContext, params[1]))
+	{
+		return 0;
+	}
+
+	if (params[2] < 1)
+	{
+		pContext->ReportError("Invalid lane weight %d", params[2]);
+		return 0;
+	}
+
+	g_TaskDispatcher.SetLaneWeight(static_cast<TaskLane>(params[1]), params[2]);
+
+	return 1;
+}
+
+static cell_t dispatch_GetLaneWeight(IPluginContext *pContext, const cell_t *params)
+{
+	if (!IsValidLane(pContext, params[1]))
+	{
+		return 0;
+	}
+
+	return g_TaskDispatcher.GetLaneWeight(static_cast<TaskLane>(params[1]));
+}
+
+static cell_t dispatch_GetLastProcessed(IPluginContext *pContext, const cell_t *params)
+{
+	return static_cast<cell_t>(g_TaskDispatcher.GetLastProcessed());
+}
+
+static cell_t dispatch_GetAverageCost(IPluginContext *pContext, const cell_t *params)
+{
+	return sp_ftoc(static_cast<float>(g_TaskDispatcher.GetAverageCost()));
+}
+
+static cell_t dispatch_GetPoolStats(IPluginContext *pContext, const cell_t *params)
+{
+	uint64_t hits, misses;
+	TaskPoolBase::GetTotals(hits, misses);
+
+	cell_t *hitsAddr, *missesAddr;
+	pContext->LocalToPhysAddr(params[1], &hitsAddr);
+	pContext->LocalToPhysAddr(params[2], &missesAddr);
+
+	*hitsAddr = static_cast<cell_t>(hits);
+	*missesAddr = static_cast<cell_t>(misses);
+
+	return 1;
+}
+
+static cell_t dispatch_GetPayloadStats(IPluginContext *pContext, const cell_t *params)
+{
+	uint64_t messages = g_PayloadStats.messages.load(std::memory_order_relaxed);
+	uint64_t bytes = g_PayloadStats.bytes.load(std::memory_order_relaxed);
+
+	cell_t *messagesAddr, *bytesAddr;
+	pContext->LocalToPhysAddr(params[1], &messagesAddr);
+	pContext->LocalToPhysAddr(params[2], &bytesAddr);
+
+	*messagesAddr = static_cast<cell_t>(messages);
+	*bytesAddr = sp_ftoc(messages ? static_cast<float>(bytes) / messages : 0.0f);
+
+	return 1;
+}
+
+static cell_t dns_SetCacheTTL(IPluginContext *pContext, const cell_t *params)
+{
+	if (params[1] < 0 || params[2] < 0)
+	{
+		pContext->ReportError("Invalid DNS cache TTL %d, negative TTL %d", params[1], params[2]);
+		return 0;
+	}
+
+	g_DnsCache.SetTTL(params[1], params[2]);
+
+	return 1;
+}
+
+static cell_t dns_GetCacheTTL(IPluginContext *pContext, const cell_t *params)
+{
+	return g_DnsCache.GetTTL();
+}
+
+static cell_t dns_Prewarm(IPluginContext *pContext, const cell_t *params)
+{
+	char *host;
+	pContext->LocalToString(params[1], &host);
+
+	if (!host[0] || params[2] < 1 || params[2] > 65535)
+	{
+		pContext->ReportError("Invalid host '%s' or port %d", host, params[2]);
+		return 0;
+	}
+
+	if (!g_DnsCache.GetTTL())
+	{
+		return 0;
+	}
+
+	g_DnsCache.Prewarm(host, params[2]);
+
+	return 1;
+}
+
+static cell_t dns_Clear(IPluginContext *pContext, const cell_t *params)
+{
+	g_DnsCache.Clear();
+
+	return 1;
+}
+
+static cell_t dns_GetStats(IPluginContext *pContext, const cell_t *params)
+{
+	cell_t *hitsAddr, *missesAddr, *entriesAddr;
+	pContext->LocalToPhysAddr(params[1], &hitsAddr);
+	pContext->LocalToPhysAddr(params[2], &missesAddr);
+	pContext->LocalToPhysAddr(params[3], &entriesAddr);
+
+	*hitsAddr = static_cast<cell_t>(g_DnsCache.GetHits());
+	*missesAddr = static_cast<cell_t>(g_DnsCache.GetMisses());
+	*entriesAddr = static_cast<cell_t>(g_DnsCache.GetSize());
+
+	return 1;
+}
+
+static cell_t tls_SetSessionCacheSize(IPluginContext *pContext, const cell_t *params)
+{
+	if (params[1] < 0)
+	{
+		pContext->ReportError("Invalid TLS session cache size %d", params[1]);
+		return 0;
+	}
+
+	ix::setTLSSessionCacheSize(params[1]);
+
+	return 1;
+}
+
+static cell_t tls_GetSessionCacheSize(IPluginContext *pContext, const cell_t *params)
+{
+	return static_cast<cell_t>(ix::getTLSSessionCacheSize());
+}
+
+static cell_t tls_ClearSessions(IPluginContext *pContext, const cell_t *params)
+{
+	ix::clearTLSSessionCache();
+
+	return 1;
+}
+
+static cell_t tls_GetSessionStats(IPluginContext *pContext, const cell_t *params)
+{
+	ix::TLSSessionCacheStats stats = ix::getTLSSessionCacheStats();
+
+	cell_t *hitsAddr, *missesAddr, *entriesAddr;
+	pContext->LocalToPhysAddr(params[1], &hitsAddr);
+	pContext->LocalToPhysAddr(params[2], &missesAddr);
+	pContext->LocalToPhysAddr(params[3], &entriesAddr);
+
+	*hitsAddr = static_cast<cell_t>(stats.hits);
+	*missesAddr = static_cast<cell_t>(stats.misses);
+	*entriesAddr = static_cast<cell_t>(stats.size);
+
+	return 1;
+}
+
+const sp_nativeinfo_t dispatch_natives[] =
+{
+	{"WebSocketDispatcher.SetFrameBudget",       dispatch_SetFrameBudget},
+	{"WebSocketDispatcher.GetFrameBudget",       dispatch_GetFrameBudget},
+	{"WebSocketDispatcher.GetMinTasks",          dispatch_GetMinTasks},
+	{"WebSocketDispatcher.IsAdaptive",           dispatch_GetAdaptive},
+	{"WebSocketDispatcher.GetPendingTasks",      dispatch_GetPendingTasks},
+	{"WebSocketDispatcher.GetLastProcessed",     dispatch_GetLastProcessed},
+	{"WebSocketDispatcher.GetAverageCost",       dispatch_GetAverageCost},
+	{"WebSocketDispatcher.GetPoolStats",         dispatch_GetPoolStats},
+	{"WebSocketDispatcher.GetPayloadStats",      dispatch_GetPayloadStats},
+	{"WebSocketDispatcher.SetLaneWeight",        dispatch_SetLaneWeight},
+	{"WebSocketDispatcher.GetLaneWeight",        dispatch_GetLaneWeight},
+	{"WebSocketDNS.SetCacheTTL",                 dns_SetCacheTTL},
+	{"WebSocketDNS.GetCacheTTL",                 dns_GetCacheTTL},
+	{"WebSocketDNS.Prewarm",                     dns_Prewarm},
+	{"WebSocketDNS.Clear",                       dns_Clear},
+	{"WebSocketDNS.GetStats",                    dns_GetStats},
+	{"WebSocketTLS.SetSessionCacheSize",         tls_SetSessionCacheSize},
+	{"WebSocketTLS.GetSessionCacheSize",         tls_GetSessionCacheSize},
+	{"WebSocketTLS.ClearSessions",               tls_ClearSessions},
+	{"WebSocketTLS.GetSessionStats",             tls_GetSessionStats},
+	{nullptr, nullptr}
+};
@@ -0,0 +1,91 @@
+#include "extension.h"
+
+void DnsCache::SetTTL(int ttlMs, int negativeTtlMs)
+{
+	m_ttlMs.store(ttlMs, std::memory_order_relaxed);
+	m_negativeTtlMs.store(negativeTtlMs, std::memory_order_relaxed);
+
+	if (!ttlMs)
+	{
+		Clear();
+	}
+}
+
+void DnsCache::Prewarm(const std::string &hostname, int port)
+{
+	// the lookup stores its answer, like ix::DNSLookup the thread may outlive the caller
+	std::thread([hostname, port] {
+		std::string errMsg;
+		auto lookup = std::make_shared<ix::DNSLookup>(hostname, port);
+		lookup->resolve(errMsg, [] { return false; }, false);
+	}).detach();
+}
+
+void DnsCache::Clear()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_entries.clear();
+}
+
+size_t DnsCache::GetSize()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_entries.size();
+}
+
+bool DnsCache::lookup(const std::string &hostname, int port, ix::DNSLookup::AddrInfoPtr &res, std::string &errMsg)
+{
+	if (!m_ttlMs.load(std::memory_order_relaxed))
+	{
+		return false;
+	}
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	auto it = m_entries.find(Key(hostname, port));
+	if (it == m_entries.end() || it->second.expires <= Clock::now())
+	{
+		m_misses.fetch_add(1, std::memory_order_relaxed);
+		return false;
+	}
+
+	m_hits.fetch_add(1, std::memory_order_relaxed);
+
+	res = it->second.res;
+	errMsg = res ? "no error" : it->second.error;
+
+	return true;
+}
+
+void DnsCache::store(const std::string &hostname, int port, const ix::DNSLookup::AddrInfoPtr &res, const std::string &errMsg)
+{
+	int ttlMs = res ? m_ttlMs.load(std::memory_order_relaxed) : m_negativeTtlMs.load(std::memory_order_relaxed);
+	if (!m_ttlMs.load(std::memory_order_relaxed) || ttlMs <= 0)
+	{
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	Clock::time_point now = Clock::now();
+
+	// expired entries are only found again by their own host, sweep them as the cache grows
+	if (m_entries.size() >= 256)
+	{
+		for (auto it = m_entries.begin(); it != m_entries.end();)
+		{
+			it = (it->second.expires <= now) ? m_entries.erase(it) : std::next(it);
+		}
+	}
+
+	Entry &entry = m_entries[Key(hostname, port)];
+	entry.res = res;
+	entry.error = errMsg;
+	entry.expires = now + std::chrono::milliseconds(ttlMs);
+}
+
+void DnsCache::invalidate(const std::string &hostname, int port)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_entries.erase(Key(hostname, port));
+}
@@ -0,0 +1,67 @@
+#include "extension.h"
+
+/**
+ * @brief Resolved addresses shared by every WebSocket and HTTP connection.
+ *
+ * getaddrinfo has no TTL, so answers are kept for a fixed time, failures for
+ * a shorter one. Addresses that could not be connected to are dropped right
+ * away, so a host that moved is looked up again on the next attempt.
+ */
+class DnsCache : public ix::DNSLookup::Cache
+{
+public:
+	using Clock = std::chrono::steady_clock;
+
+	/**
+	 * @brief Sets how long answers are kept, 0 disables caching and clears the cache.
+	 */
+	void SetTTL(int ttlMs, int negativeTtlMs);
+
+	int GetTTL() const {
+		return m_ttlMs.load(std::memory_order_relaxed);
+	}
+
+	/**
+	 * @brief Resolves a host in the background so the first connect finds it cached.
+	 */
+	void Prewarm(const std::string &hostname, int port);
+
+	void Clear();
+
+	size_t GetSize();
+
+	uint64_t GetHits() const {
+		return m_hits.load(std::memory_order_relaxed);
+	}
+
+	uint64_t GetMisses() const {
+		return m_misses.load(std::memory_order_relaxed);
+	}
+
+	virtual bool lookup(const std::string &hostname, int port, ix::DNSLookup::AddrInfoPtr &res, std::string &errMsg) override;
+	virtual void store(const std::string &hostname, int port, const ix::DNSLookup::AddrInfoPtr &res, const std::string &errMsg) override;
+	virtual void invalidate(const std::string &hostname, int port) override;
+
+private:
+	static std::string Key(const std::string &hostname, int port) {
+		return hostname + ':' + std::to_string(port);
+	}
+
+	struct Entry
+	{
+		ix::DNSLookup::AddrInfoPtr res;
+		std::string error;
+		Clock::time_point expires;
+	};
+
+	std::mutex m_mutex;
+	std::unordered_map<std::string, Entry> m_entries;
+
+	std::atomic<int> m_ttlMs{60000};
+	std::atomic<int> m_negativeTtlMs{5000};
+
+	std::atomic<uint64_t> m_hits{0};
+	std::atomic<uint64_t> m_misses{0};
+};
+
+extern DnsCache g_DnsCache;
@@ -1,7 +1,5 @@
 #include "extension.h"
 
-#define MAX_PROCESS 10
-
 WebsocketExtension g_WebsocketExt;
 SMEXT_LINK(&g_WebsocketExt);
 
@@ -11,28 +9,21 @@ WsServerHandler g_WsServerHandler;
 JSONHandler g_JSONHandler;
 HttpHandler g_HttpHandler;
 
-ThreadSafeQueue<ITaskContext *> g_TaskQueue;
+MpscQueue<ITaskContext> g_TaskQueues[TaskLane_Count];
+TaskDispatcher g_TaskDispatcher;
+ix::WebSocketReactor g_WebSocketReactor;
+Scheduler g_Scheduler;
+Scheduler g_JsonWorker;
+PayloadStats g_PayloadStats;
+DnsCache g_DnsCache;
 
 static void OnGameFrame(bool simulating) {
-	int count = 0;
-	ITaskContext *context = nullptr;
-	
-	while (count < MAX_PROCESS) {
-		if (!g_TaskQueue.TryPop(context)) {
-			break;
-		}
-		
-		if (context) {
-			context->OnCompleted();
-			delete context;
-			count++;
-		}
-	}
+	g_TaskDispatcher.RunFrame();
 }
 
-void WebsocketExtension::AddTaskToQueue(ITaskContext *context)
+void WebsocketExtension::AddTaskToQueue(ITaskContext *context, TaskLane lane)
 {
-	g_TaskQueue.Push(context);
+	g_TaskQueues[lane].Push(context);
 }
 
 bool WebsocketExtension::SDK_OnLoad(char* error, size_t maxlen, bool late)
@@ -41,6 +32,7 @@ bool WebsocketExtension::SDK_OnLoad(char* error, size_t maxlen, bool late)
 	sharesys->AddNatives(myself, ws_natives_server);
 	sharesys->AddNatives(myself, json_natives);
 	sharesys->AddNatives(myself, http_natives);
+	sharesys->AddNatives(myself, dispatch_natives);
 	sharesys->RegisterLibrary(myself, "websocket");
 	
 	HandleAccess haDefaults;
@@ -51,6 +43,8 @@ bool WebsocketExtension::SDK_OnLoad(char* error, size_t maxlen, bool late)
 	g_htHttp = handlesys->CreateType("HttpRequest", &g_HttpHandler, 0, nullptr, &haDefaults, myself->GetIdentity(), nullptr);
 	g_htJSON = handlesys->CreateType("YYJSON", &g_JSONHandler, 0, nullptr, &haDefaults, myself->GetIdentity(), nullptr);
 
+	ix::DNSLookup::setCache(&g_DnsCache);
+
 	smutils->AddGameFrameHook(&OnGameFrame);
 	return true;
 }
@@ -62,6 +56,13 @@ void WebsocketExtension::SDK_OnUnload()
 	handlesys->RemoveType(g_htJSON, myself->GetIdentity());
 	handlesys->RemoveType(g_htHttp, myself->GetIdentity());
 
+	// removing the client type stopped every client made by a plugin, the only ones the loop drives,
+	// connections accepted by a server are left to the server and never use it
+	g_WebSocketReactor.stop();
+	g_Scheduler.Shutdown();
+	g_JsonWorker.Shutdown();
+	ix::DNSLookup::setCache(nullptr);
+
 	smutils->RemoveGameFrameHook(&OnGameFrame);
 }
 
@@ -98,4 +99,26 @@ YYJsonWrapper *WebsocketExtension::GetJSONPointer(IPluginContext *pContext, Hand
 	}
 
 	return pYYJsonWrapper;
+}
+
+char *WebsocketExtension::GetBinaryPointer(IPluginContext *pContext, cell_t address, cell_t length)
+{
+	if (length < 0)
+	{
+		pContext->ReportError("Invalid binary length %d", length);
+		return nullptr;
+	}
+
+	// the length comes from the plugin, so its last byte has to be plugin memory as well
+	int64_t last = static_cast<int64_t>(address) + length - 1;
+	cell_t *data, *end;
+
+	if (pContext->LocalToPhysAddr(address, &data) != SP_ERROR_NONE
+		|| (length && (last > INT32_MAX || pContext->LocalToPhysAddr(static_cast<cell_t>(last), &end) != SP_ERROR_NONE)))
+	{
+		pContext->ReportError("Binary length %d exceeds the data array", length);
+		return nullptr;
+	}
+
+	return reinterpret_cast<char *>(data);
 }
\ No newline at end of file
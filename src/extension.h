@@ -3,16 +3,38 @@
 
 #include "smsdk_ext.h"
 #include <yyjson.h>
+#include <unordered_set>
+#include <deque>
+#include <algorithm>
 #include <IXWebSocket.h>
 #include <IXWebSocketServer.h>
+#include <IXWebSocketReactor.h>
 #include <IXHttpClient.h>
+#include <IXUtf8Validator.h>
+#include <IXDNSLookup.h>
+#include <IXTLSSessionCache.h>
 #include <yyjsonwrapper.h>
+#include <task_pool.h>
 #include <task_context.h>
+#include <task_source.h>
+#include <payload.h>
+#include <connection_stats.h>
+#include <message_batch.h>
+#include <send_buffer.h>
+#include <message_filter.h>
+#include <scheduler.h>
+#include <heartbeat.h>
+#include <rate_limiter.h>
+#include <json_writer.h>
+#include <dns_cache.h>
 #include <ws_client.h>
 #include <ws_server.h>
 #include <http_request.h>
 #include <queue.h>
+#include <task_dispatcher.h>
 #include <random>
+#include <chrono>
+#include <atomic>
 
 class WebsocketExtension : public SDKExtension
 {
@@ -20,8 +42,9 @@ public:
 	virtual bool SDK_OnLoad(char *error, size_t maxlength, bool late);
 	virtual void SDK_OnUnload();
 	virtual YYJsonWrapper *GetJSONPointer(IPluginContext *pContext, Handle_t handle);
+	virtual char *GetBinaryPointer(IPluginContext *pContext, cell_t address, cell_t length);
 	public:
-		void AddTaskToQueue(ITaskContext *context);
+		void AddTaskToQueue(ITaskContext *context, TaskLane lane);
 };
 
 class WsClientHandler : public IHandleTypeDispatch
@@ -54,11 +77,17 @@ extern WsClientHandler g_WsClientHandler;
 extern WsServerHandler g_WsServerHandler;
 extern JSONHandler g_JSONHandler;
 extern HttpHandler g_HttpHandler;
-extern ThreadSafeQueue<ITaskContext *> g_TaskQueue;
+extern MpscQueue<ITaskContext> g_TaskQueues[TaskLane_Count];
+extern TaskDispatcher g_TaskDispatcher;
+extern ix::WebSocketReactor g_WebSocketReactor;
+extern Scheduler g_Scheduler;
+extern Scheduler g_JsonWorker;
+extern PayloadStats g_PayloadStats;
 
 extern const sp_nativeinfo_t ws_natives[];
 extern const sp_nativeinfo_t ws_natives_server[];
 extern const sp_nativeinfo_t json_natives[];
 extern const sp_nativeinfo_t http_natives[];
+extern const sp_nativeinfo_t dispatch_natives[];
 
 #endif // _INCLUDE_SOURCEMOD_EXTENSION_PROPER_H_
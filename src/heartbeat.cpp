@@ -0,0 +1,180 @@
+#include "extension.h"
+
+static bool IsValidPointer(const char *pointer)
+{
+	return pointer[0] == '\0' || pointer[0] == '/';
+}
+
+bool Heartbeat::Start(int intervalMs, const char *payload, const char *seqPointer,
+	const char *ackPointer, const char *ackValue, std::string &error)
+{
+	if (!IsValidPointer(seqPointer) || !IsValidPointer(ackPointer))
+	{
+		error = "JSON pointer must be empty or start with '/'";
+		return false;
+	}
+
+	Stop();
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	m_payload = payload;
+	m_seqPointer = seqPointer;
+	m_ackPointer = ackPointer;
+	m_ackText = ackValue;
+	m_ackValue = MessageFilter::ParseValue(ackValue);
+	m_seq = "null";
+	m_awaitingAck = false;
+	m_rtt.store(-1, std::memory_order_relaxed);
+
+	m_interval = std::chrono::milliseconds(intervalMs);
+	m_next = Scheduler::Clock::now() + m_interval;
+	m_active = true;
+	m_timerId = g_Scheduler.Schedule(m_next, [this] { Tick(); });
+
+	m_observing.store(!m_seqPointer.empty() || !m_ackPointer.empty(), std::memory_order_release);
+
+	return true;
+}
+
+void Heartbeat::Stop()
+{
+	uint64_t timerId;
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if (!m_active)
+		{
+			return;
+		}
+
+		m_active = false;
+		m_observing.store(false, std::memory_order_release);
+		timerId = m_timerId;
+	}
+
+	// the tick only reschedules itself while active, so this is the last one
+	g_Scheduler.Cancel(timerId);
+}
+
+bool Heartbeat::Observe(yyjson_doc *document, int &rtt)
+{
+	if (!document)
+	{
+		return false;
+	}
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	if (!m_seqPointer.empty())
+	{
+		yyjson_val *val = yyjson_doc_ptr_getn(document, m_seqPointer.c_str(), m_seqPointer.length());
+		if (val && !yyjson_is_null(val))
+		{
+			size_t len;
+			char *seq = yyjson_val_write(val, 0, &len);
+			if (seq)
+			{
+				m_seq.assign(seq, len);
+				free(seq);
+			}
+		}
+	}
+
+	if (!m_awaitingAck || m_ackPointer.empty())
+	{
+		return false;
+	}
+
+	yyjson_val *val = yyjson_doc_ptr_getn(document, m_ackPointer.c_str(), m_ackPointer.length());
+	if (!val || !MessageFilter::ValueEquals(val, m_ackValue.get(), m_ackText))
+	{
+		return false;
+	}
+
+	m_awaitingAck = false;
+	rtt = static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(Scheduler::Clock::now() - m_sentAt).count());
+	m_rtt.store(rtt, std::memory_order_relaxed);
+
+	return true;
+}
+
+void Heartbeat::Tick()
+{
+	std::string payload;
+	bool missed = false;
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if (!m_active)
+		{
+			return;
+		}
+
+		if (m_client->IsConnected())
+		{
+			payload = m_payload;
+			for (size_t pos = payload.find("{seq}"); pos != std::string::npos; pos = payload.find("{seq}", pos + m_seq.length()))
+			{
+				payload.replace(pos, 5, m_seq);
+			}
+
+			missed = m_awaitingAck;
+			m_awaitingAck = !m_ackPointer.empty();
+			m_sentAt = Scheduler::Clock::now();
+		}
+		else
+		{
+			m_awaitingAck = false;
+		}
+	}
+
+	if (!payload.empty())
+	{
+		m_client->SendNow(payload.c_str(), payload.length(), false);
+	}
+
+	if (missed)
+	{
+		Report(-1);
+	}
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	if (!m_active)
+	{
+		return;
+	}
+
+	// fixed rate, but never try to catch up on beats missed while the thread was busy
+	auto now = Scheduler::Clock::now();
+	m_next += m_interval;
+	if (m_next < now)
+	{
+		m_next = now + m_interval;
+	}
+
+	m_timerId = g_Scheduler.Schedule(m_next, [this] { Tick(); });
+}
+
+void Heartbeat::Report(int rtt)
+{
+	if (!m_client->pHeartbeatForward || !m_client->pHeartbeatForward->GetFunctionCount())
+	{
+		return;
+	}
+
+	m_client->Queue(new HeartbeatTaskContext(m_client, rtt), TaskLane_Control);
+}
+
+HeartbeatTaskContext::HeartbeatTaskContext(WebSocketClient *client, int rtt) : SourceTaskContext(client), m_client(client), m_rtt(rtt) {}
+
+void HeartbeatTaskContext::OnCompleted()
+{
+	if (!m_client->pHeartbeatForward)
+	{
+		return;
+	}
+
+	m_client->pHeartbeatForward->PushCell(m_client->m_websocket_handle);
+	m_client->pHeartbeatForward->PushCell(m_rtt);
+	m_client->pHeartbeatForward->Execute(nullptr);
+}
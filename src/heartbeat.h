@@ -0,0 +1,96 @@
+#include "extension.h"
+
+class WebSocketClient;
+
+/**
+ * @brief Sends an application level keepalive from the scheduler thread.
+ *
+ * The payload is a template where {seq} is replaced with the JSON value last
+ * seen at a pointer in incoming messages, or null before the first one. When
+ * an ack rule is set, the round trip time is measured from the send to the
+ * first incoming message whose value at the ack pointer equals the ack value.
+ */
+class Heartbeat
+{
+public:
+	explicit Heartbeat(WebSocketClient *client) : m_client(client) {}
+	~Heartbeat() { Stop(); }
+
+	Heartbeat(const Heartbeat&) = delete;
+	Heartbeat& operator=(const Heartbeat&) = delete;
+
+	/**
+	 * @brief Starts sending, called on the game thread.
+	 *
+	 * @return false with error set if a pointer is invalid.
+	 */
+	bool Start(int intervalMs, const char *payload, const char *seqPointer,
+		const char *ackPointer, const char *ackValue, std::string &error);
+
+	/**
+	 * @brief Stops sending, returns once no heartbeat is being sent.
+	 */
+	void Stop();
+
+	/**
+	 * @brief Whether incoming messages have to be parsed and passed to Observe.
+	 */
+	bool IsObserving() const {
+		return m_observing.load(std::memory_order_acquire);
+	}
+
+	/**
+	 * @brief Records the sequence and checks for an ack, called on a network thread.
+	 *
+	 * @return true if the message acknowledged the last heartbeat, with rtt set in milliseconds.
+	 */
+	bool Observe(yyjson_doc *document, int &rtt);
+
+	int GetRTT() const {
+		return m_rtt.load(std::memory_order_relaxed);
+	}
+
+	/**
+	 * @brief Queues the heartbeat callback, rtt is -1 for a heartbeat that was never acked.
+	 */
+	void Report(int rtt);
+
+private:
+	void Tick();
+
+	WebSocketClient *m_client;
+
+	std::mutex m_mutex;
+	bool m_active = false;
+	uint64_t m_timerId = 0;
+	Scheduler::Clock::duration m_interval;
+	Scheduler::Clock::time_point m_next;
+
+	std::string m_payload;
+	std::string m_seqPointer;
+	std::string m_ackPointer;
+	std::shared_ptr<yyjson_doc> m_ackValue;
+	std::string m_ackText;
+
+	// raw JSON text of the last sequence value
+	std::string m_seq = "null";
+
+	bool m_awaitingAck = false;
+	Scheduler::Clock::time_point m_sentAt;
+
+	std::atomic<bool> m_observing{false};
+	std::atomic<int> m_rtt{-1};
+};
+
+class HeartbeatTaskContext : public SourceTaskContext<HeartbeatTaskContext>
+{
+public:
+	// defined with WebSocketClient complete, it is a TaskSource
+	HeartbeatTaskContext(WebSocketClient *client, int rtt);
+
+	virtual void OnCompleted() override;
+
+private:
+	WebSocketClient *m_client;
+	int m_rtt;
+};
@@ -79,7 +79,8 @@ static cell_t http_PostJson(IPluginContext *pContext, const cell_t *params)
 	}
 
 	cell_t value = params[4];
-	return pHttpRequest->PostJson(json, callback, value);
+	bool async = params[0] >= 5 && params[5];
+	return pHttpRequest->PostJson(json, callback, value, async);
 }
 
 static cell_t http_AppendFormParam(IPluginContext *pContext, const cell_t *params)
@@ -140,7 +141,8 @@ static cell_t http_PutJson(IPluginContext *pContext, const cell_t *params)
 	}
 
 	cell_t value = params[4];
-	return pHttpRequest->PutJson(json, callback, value);
+	bool async = params[0] >= 5 && params[5];
+	return pHttpRequest->PutJson(json, callback, value, async);
 }
 
 static cell_t http_PatchJson(IPluginContext *pContext, const cell_t *params)
@@ -165,7 +167,8 @@ static cell_t http_PatchJson(IPluginContext *pContext, const cell_t *params)
 	}
 
 	cell_t value = params[4];
-	return pHttpRequest->PatchJson(json, callback, value);
+	bool async = params[0] >= 5 && params[5];
+	return pHttpRequest->PatchJson(json, callback, value, async);
 }
 
 static cell_t http_Delete(IPluginContext *pContext, const cell_t *params)
@@ -338,6 +341,42 @@ static cell_t http_SetVerbose(IPluginContext *pContext, const cell_t *params)
 	return 1;
 }
 
+static cell_t http_SetDropCallback(IPluginContext *pContext, const cell_t *params)
+{
+	HttpRequest *pHttpRequest = GetHttpPointer(pContext, params[1]);
+	if (!pHttpRequest) return 0;
+
+	IPluginFunction *callback = pContext->GetFunctionById(params[2]);
+
+	if (pHttpRequest->pDropForward) {
+		forwards->ReleaseForward(pHttpRequest->pDropForward);
+	}
+
+	pHttpRequest->pDropForward = forwards->CreateForwardEx(nullptr, ET_Ignore, 2, nullptr, Param_Cell, Param_Cell);
+	if (!pHttpRequest->pDropForward || !pHttpRequest->pDropForward->AddFunction(callback))
+	{
+		pContext->ReportError("Could not create drop forward.");
+		return 0;
+	}
+
+	return 1;
+}
+
+static cell_t http_SetQueueLimit(IPluginContext *pContext, const cell_t *params)
+{
+	HttpRequest *pHttpRequest = GetHttpPointer(pContext, params[1]);
+	if (!pHttpRequest) return 0;
+
+	if (params[2] < 0 || params[3] < QueuePolicy_DropOldest || params[3] > QueuePolicy_Pause)
+	{
+		pContext->ReportError("Invalid queue limit %d or policy %d", params[2], params[3]);
+		return 0;
+	}
+
+	pHttpRequest->SetQueueLimit(params[2], static_cast<QueuePolicy>(params[3]));
+	return 1;
+}
+
 const sp_nativeinfo_t http_natives[] =
 {
 	{"HttpRequest.HttpRequest", http_CreateRequest},
@@ -363,5 +402,7 @@ const sp_nativeinfo_t http_natives[] =
 	{"HttpRequest.MaxRedirects.set", http_SetMaxRedirects},
 	{"HttpRequest.Verbose.get", http_GetVerbose},
 	{"HttpRequest.Verbose.set", http_SetVerbose},
+	{"HttpRequest.SetDropCallback", http_SetDropCallback},
+	{"HttpRequest.SetQueueLimit", http_SetQueueLimit},
 	{nullptr, nullptr}
 };
\ No newline at end of file
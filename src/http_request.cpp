@@ -1,12 +1,13 @@
 #include "extension.h"
 
-HttpRequest::HttpRequest(const std::string &url) : m_httpclient(true)
+HttpRequest::HttpRequest(const std::string &url) : TaskSource(TaskLane_Http), m_httpclient(true)
 {
 	m_request = m_httpclient.createRequest(url);
 }
 
 HttpRequest::~HttpRequest() 
 {
+	m_jsonWriter.Cancel();
 	if (pResponseForward) forwards->ReleaseForward(pResponseForward);
 }
 
@@ -102,8 +103,15 @@ void HttpRequest::onResponse(const ix::HttpResponsePtr response, IPluginFunction
 		m_responseHeaders = response->headers;
 	}
 
-	HttpResponseTaskContext *context = new HttpResponseTaskContext(this, response, callback, value);
-	g_WebsocketExt.AddTaskToQueue(context);
+	// a dropped response is still queued, the handle has to be freed on the game thread
+	uint64_t seq;
+	if (!Admit(seq))
+	{
+		seq = 0;
+	}
+
+	HttpResponseTaskContext *context = new HttpResponseTaskContext(this, response, callback, value, seq);
+	Queue(context, GetDataLane());
 }
 
 void HttpResponseTaskContext::OnCompleted()
@@ -111,12 +119,15 @@ void HttpResponseTaskContext::OnCompleted()
 	HandleError err;
 	HandleSecurity sec(nullptr, myself->GetIdentity());
 
-	m_client->pResponseForward->PushCell(m_client->m_httpclient_handle);
-	m_client->pResponseForward->PushString(m_response->body.c_str());
-	m_client->pResponseForward->PushCell(m_response->statusCode);
-	m_client->pResponseForward->PushCell(m_response->body.size());
-	m_client->pResponseForward->PushCell(m_value);
-	m_client->pResponseForward->Execute(nullptr);
+	if (m_seq && m_client->Consume(m_seq))
+	{
+		m_client->pResponseForward->PushCell(m_client->m_httpclient_handle);
+		m_client->pResponseForward->PushString(m_response->body.c_str());
+		m_client->pResponseForward->PushCell(m_response->statusCode);
+		m_client->pResponseForward->PushCell(m_response->body.size());
+		m_client->pResponseForward->PushCell(m_value);
+		m_client->pResponseForward->Execute(nullptr);
+	}
 
 	handlesys->FreeHandle(m_client->m_httpclient_handle, &sec);
 }
@@ -130,40 +141,86 @@ bool HttpRequest::Get(IPluginFunction *callback, cell_t value)
 		});
 }
 
-bool HttpRequest::PostJson(YYJsonWrapper* json, IPluginFunction *callback, cell_t value)
+// everything but the body, HttpRequestArgs holds an atomic and cannot be copied as a whole
+static ix::HttpRequestArgsPtr CopyRequest(const ix::HttpRequestArgs &request)
+{
+	auto args = std::make_shared<ix::HttpRequestArgs>();
+	args->url = request.url;
+	args->verb = request.verb;
+	args->extraHeaders = request.extraHeaders;
+	args->multipartBoundary = request.multipartBoundary;
+	args->connectTimeout = request.connectTimeout;
+	args->transferTimeout = request.transferTimeout;
+	args->followRedirects = request.followRedirects;
+	args->maxRedirects = request.maxRedirects;
+	args->verbose = request.verbose;
+	args->compress = request.compress;
+	args->compressRequest = request.compressRequest;
+	args->logger = request.logger;
+	args->onProgressCallback = request.onProgressCallback;
+	args->onChunkCallback = request.onChunkCallback;
+	args->cancel = false;
+	return args;
+}
+
+bool HttpRequest::PerformJson(YYJsonWrapper* json, IPluginFunction *callback, cell_t value, bool async)
+{
+	auto onResponseCallback = [this, callback, value](const ix::HttpResponsePtr& response) {
+		onResponse(response, callback, value);
+	};
+
+	if (!async) {
+		SetJsonBody(json);
+		return m_httpclient.performRequest(m_request, onResponseCallback);
+	}
+
+	YYJsonDocPtr snapshot = json->IsMutable()
+		? AsyncJsonWriter::Snapshot(yyjson_mut_doc_get_root(json->m_pDocument_mut.get()))
+		: AsyncJsonWriter::Snapshot(yyjson_doc_get_root(json->m_pDocument.get()));
+
+	if (!snapshot) return false;
+
+	// the worker fills in the body of a copy, so the request can be changed meanwhile
+	auto args = CopyRequest(*m_request);
+	args->extraHeaders["Content-Type"] = "application/json";
+
+	m_jsonWriter.Submit(std::move(snapshot), [this, args, onResponseCallback](std::string &&text) {
+		// answered like a request that could not be sent, rather than sending an empty body
+		if (text.empty())
+		{
+			onResponseCallback(std::make_shared<ix::HttpResponse>(0, "", ix::HttpErrorCode::Invalid, ix::WebSocketHttpHeaders(), "", "Could not write the JSON body"));
+			return;
+		}
+
+		args->body = std::move(text);
+		m_httpclient.performRequest(args, onResponseCallback);
+	});
+
+	return true;
+}
+
+bool HttpRequest::PostJson(YYJsonWrapper* json, IPluginFunction *callback, cell_t value, bool async)
 {
 	if (!json) return false;
 	
 	m_request->verb = "POST";
-	SetJsonBody(json);
-	return m_httpclient.performRequest(m_request, 
-		[this, callback, value](const ix::HttpResponsePtr& response) {
-			onResponse(response, callback, value);
-		});
+	return PerformJson(json, callback, value, async);
 }
 
-bool HttpRequest::PutJson(YYJsonWrapper* json, IPluginFunction *callback, cell_t value)
+bool HttpRequest::PutJson(YYJsonWrapper* json, IPluginFunction *callback, cell_t value, bool async)
 {
 	if (!json) return false;
 	
 	m_request->verb = "PUT";
-	SetJsonBody(json);
-	return m_httpclient.performRequest(m_request, 
-		[this, callback, value](const ix::HttpResponsePtr& response) {
-			onResponse(response, callback, value);
-		});
+	return PerformJson(json, callback, value, async);
 }
 
-bool HttpRequest::PatchJson(YYJsonWrapper* json, IPluginFunction *callback, cell_t value)
+bool HttpRequest::PatchJson(YYJsonWrapper* json, IPluginFunction *callback, cell_t value, bool async)
 {
 	if (!json) return false;
 	
 	m_request->verb = "PATCH";
-	SetJsonBody(json);
-	return m_httpclient.performRequest(m_request, 
-		[this, callback, value](const ix::HttpResponsePtr& response) {
-			onResponse(response, callback, value);
-		});
+	return PerformJson(json, callback, value, async);
 }
 
 bool HttpRequest::PostForm(IPluginFunction *callback, cell_t value)
@@ -1,16 +1,18 @@
 #include "extension.h"
 
-class HttpRequest
+class HttpRequest : public TaskSource
 {
 public:
 	HttpRequest(const std::string &url);
 	~HttpRequest();
 
+	virtual Handle_t GetSourceHandle() override { return m_httpclient_handle; }
+
 	bool Get(IPluginFunction *callback, cell_t value);
 	bool Delete(IPluginFunction *callback, cell_t value);
-	bool PostJson(YYJsonWrapper* json, IPluginFunction *callback, cell_t value);
-	bool PutJson(YYJsonWrapper* json, IPluginFunction *callback, cell_t value);
-	bool PatchJson(YYJsonWrapper* json, IPluginFunction *callback, cell_t value);
+	bool PostJson(YYJsonWrapper* json, IPluginFunction *callback, cell_t value, bool async = false);
+	bool PutJson(YYJsonWrapper* json, IPluginFunction *callback, cell_t value, bool async = false);
+	bool PatchJson(YYJsonWrapper* json, IPluginFunction *callback, cell_t value, bool async = false);
 	bool PostForm(IPluginFunction *callback, cell_t value);
 
 	void AppendFormParam(const std::string &key, const std::string &value);
@@ -47,13 +49,16 @@ private:
 	std::map<std::string, std::string> m_formParams;
 
 	std::string BuildFormData();
+	bool PerformJson(YYJsonWrapper* json, IPluginFunction *callback, cell_t value, bool async);
+
+	AsyncJsonWriter m_jsonWriter;
 };
 
-class HttpResponseTaskContext : public ITaskContext
+class HttpResponseTaskContext : public SourceTaskContext<HttpResponseTaskContext>
 {
 public:
-	HttpResponseTaskContext(HttpRequest* client, const ix::HttpResponsePtr& response, IPluginFunction *callback, cell_t value) 
-		: m_client(client), m_response(response), m_callback(callback), m_value(value){}
+	HttpResponseTaskContext(HttpRequest* client, const ix::HttpResponsePtr& response, IPluginFunction *callback, cell_t value, uint64_t seq) 
+		: SourceTaskContext(client), m_client(client), m_response(response), m_callback(callback), m_value(value), m_seq(seq) {}
 	
 	virtual void OnCompleted() override;
 	
@@ -62,4 +67,6 @@ private:
 	ix::HttpResponsePtr m_response;
 	IPluginFunction *m_callback;
 	cell_t m_value;
+	// 0 when the response was dropped by the queue limit
+	uint64_t m_seq;
 };
\ No newline at end of file
@@ -0,0 +1,149 @@
+#include "extension.h"
+
+static void *SnapshotMalloc(void *ctx, size_t size)
+{
+	return malloc(size);
+}
+
+static void *SnapshotRealloc(void *ctx, void *ptr, size_t old_size, size_t size)
+{
+	return realloc(ptr, size);
+}
+
+static void SnapshotFree(void *ctx, void *ptr)
+{
+	free(ptr);
+}
+
+static const yyjson_alc s_snapshotAlc = { SnapshotMalloc, SnapshotRealloc, SnapshotFree, nullptr };
+
+static bool HasStringPayload(yyjson_val *val)
+{
+	yyjson_type type = unsafe_yyjson_get_type(val);
+	return type == YYJSON_TYPE_STR || type == YYJSON_TYPE_RAW;
+}
+
+/**
+ * @brief Copies an immutable value into a new document in one pass.
+ *
+ * The values of a subtree are contiguous and containers only store relative
+ * offsets, so they are copied as one block. Strings may point into the source
+ * document or its input, so they are moved into a pool owned by the copy.
+ */
+static yyjson_doc *CopyImmutable(yyjson_val *val)
+{
+	size_t count = (size_t)(unsafe_yyjson_get_next(val) - val);
+	size_t strSize = 0;
+	for (size_t i = 0; i < count; i++)
+	{
+		if (HasStringPayload(val + i))
+		{
+			strSize += unsafe_yyjson_get_len(val + i) + 1;
+		}
+	}
+
+	// yyjson_doc_free releases the values with the document header
+	size_t headerSize = (sizeof(yyjson_doc) + sizeof(yyjson_val) - 1) / sizeof(yyjson_val) * sizeof(yyjson_val);
+	yyjson_doc *doc = (yyjson_doc *)malloc(headerSize + count * sizeof(yyjson_val));
+	if (!doc)
+	{
+		return nullptr;
+	}
+
+	memset(doc, 0, sizeof(yyjson_doc));
+	doc->alc = s_snapshotAlc;
+	doc->root = (yyjson_val *)((char *)doc + headerSize);
+	memcpy(doc->root, val, count * sizeof(yyjson_val));
+
+	if (strSize > 0)
+	{
+		doc->str_pool = (char *)malloc(strSize);
+		if (!doc->str_pool)
+		{
+			free(doc);
+			return nullptr;
+		}
+	}
+
+	char *str = doc->str_pool;
+	for (size_t i = 0; i < count; i++)
+	{
+		yyjson_val *copy = doc->root + i;
+		if (HasStringPayload(copy))
+		{
+			size_t len = unsafe_yyjson_get_len(copy);
+			memcpy(str, copy->uni.str, len);
+			str[len] = '\0';
+			copy->uni.str = str;
+			str += len + 1;
+		}
+	}
+
+	doc->val_read = count;
+	doc->dat_read = strSize + 1;
+
+	return doc;
+}
+
+YYJsonDocPtr AsyncJsonWriter::Snapshot(yyjson_mut_val *val)
+{
+	if (!val)
+	{
+		return nullptr;
+	}
+
+	return YYJsonDocPtr(yyjson_mut_val_imut_copy(val, nullptr));
+}
+
+YYJsonDocPtr AsyncJsonWriter::Snapshot(yyjson_val *val)
+{
+	if (!val)
+	{
+		return nullptr;
+	}
+
+	// immutable values never change, but they are freed with their handle
+	return YYJsonDocPtr(CopyImmutable(val));
+}
+
+void AsyncJsonWriter::Submit(YYJsonDocPtr snapshot, Callback callback)
+{
+	// std::function needs a copyable target
+	auto document = std::make_shared<YYJsonDocPtr>(std::move(snapshot));
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	uint64_t ticket = m_nextTicket++;
+
+	m_pending[ticket] = g_JsonWorker.Post([this, ticket, document, callback = std::move(callback)] {
+		std::string text;
+
+		size_t len;
+		char *json = yyjson_write(document->get(), 0, &len);
+		if (json)
+		{
+			text.assign(json, len);
+			free(json);
+		}
+
+		document->reset();
+		callback(std::move(text));
+
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_pending.erase(ticket);
+	});
+}
+
+void AsyncJsonWriter::Cancel()
+{
+	std::unordered_map<uint64_t, uint64_t> pending;
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		pending.swap(m_pending);
+	}
+
+	for (const auto &job : pending)
+	{
+		g_JsonWorker.Cancel(job.second);
+	}
+}
@@ -0,0 +1,45 @@
+#include "extension.h"
+
+/**
+ * @brief Serializes JSON snapshots on the JSON worker thread for one owner.
+ *
+ * The game thread only takes a frozen copy of the value, which is much
+ * cheaper than writing it, so the handle can be changed or closed right
+ * away. Jobs of one owner run in submission order. Destroying the writer
+ * drops pending jobs and waits for a running one, so the owner must do
+ * that before releasing anything the callbacks touch.
+ */
+class AsyncJsonWriter
+{
+public:
+	// receives the JSON text, empty if the value could not be written
+	using Callback = std::function<void(std::string &&text)>;
+
+	AsyncJsonWriter() = default;
+	~AsyncJsonWriter() { Cancel(); }
+
+	AsyncJsonWriter(const AsyncJsonWriter&) = delete;
+	AsyncJsonWriter& operator=(const AsyncJsonWriter&) = delete;
+
+	/**
+	 * @brief Takes a frozen copy of a value, called on the game thread.
+	 */
+	static YYJsonDocPtr Snapshot(yyjson_mut_val *val);
+	static YYJsonDocPtr Snapshot(yyjson_val *val);
+
+	/**
+	 * @brief Queues a snapshot to be written and passed to callback on the worker.
+	 */
+	void Submit(YYJsonDocPtr snapshot, Callback callback);
+
+	/**
+	 * @brief Drops pending jobs and waits for a running one to return.
+	 */
+	void Cancel();
+
+private:
+	std::mutex m_mutex;
+	// job ticket -> scheduler id, removed by the job once it returns
+	std::unordered_map<uint64_t, uint64_t> m_pending;
+	uint64_t m_nextTicket = 1;
+};
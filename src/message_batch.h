@@ -0,0 +1,56 @@
+#include "extension.h"
+
+struct BatchedMessage
+{
+	std::string message;
+	uint64_t seq = 0;
+
+	// parsed on the network thread for WebSocket_JSON clients
+	YYJsonDocPtr document;
+	std::string parseError;
+
+	// set for messages received by a WebSocketServer
+	std::shared_ptr<ix::ConnectionState> connectionState;
+};
+
+/**
+ * @brief Collects messages for a batched callback.
+ *
+ * Network threads append messages and only the first message after a flush
+ * asks the caller to queue a flush task, so every message that arrives
+ * before the game thread runs that task is delivered in the same call.
+ */
+class MessageBatch
+{
+public:
+	/**
+	 * @brief Appends a message, called on a network thread.
+	 *
+	 * @return true if the caller must queue a flush task.
+	 */
+	bool Add(BatchedMessage &&message) {
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_messages.push_back(std::move(message));
+
+		if (m_flushQueued) {
+			return false;
+		}
+
+		m_flushQueued = true;
+		return true;
+	}
+
+	/**
+	 * @brief Takes every collected message, called by the flush task on the game thread.
+	 */
+	void Take(std::vector<BatchedMessage> &out) {
+		std::lock_guard<std::mutex> lock(m_mutex);
+		out.swap(m_messages);
+		m_flushQueued = false;
+	}
+
+private:
+	std::mutex m_mutex;
+	std::vector<BatchedMessage> m_messages;
+	bool m_flushQueued = false;
+};
@@ -0,0 +1,121 @@
+#include "extension.h"
+
+bool MessageFilter::AddRule(const char *pointer, const char *value, FilterMatch match, std::string &error)
+{
+	if (pointer[0] != '\0' && pointer[0] != '/')
+	{
+		error = "JSON pointer must be empty or start with '/'";
+		return false;
+	}
+
+	Rule rule;
+	rule.pointer = pointer;
+	rule.match = match;
+	rule.text = value;
+
+	if (match == FilterMatch_Equals)
+	{
+		rule.value = ParseValue(value);
+	}
+
+	auto rules = std::make_shared<RuleSet>(*std::atomic_load(&m_rules));
+	rules->rules.push_back(std::move(rule));
+	Store(rules);
+
+	return true;
+}
+
+std::shared_ptr<yyjson_doc> MessageFilter::ParseValue(const char *value)
+{
+	yyjson_doc *doc = yyjson_read(value, strlen(value), 0);
+	if (!doc)
+	{
+		return nullptr;
+	}
+
+	return std::shared_ptr<yyjson_doc>(doc, yyjson_doc_free);
+}
+
+bool MessageFilter::ValueEquals(yyjson_val *val, yyjson_doc *value, const std::string &text)
+{
+	if (value)
+	{
+		return yyjson_equals(val, yyjson_doc_get_root(value));
+	}
+
+	return yyjson_equals_strn(val, text.c_str(), text.length());
+}
+
+void MessageFilter::Clear()
+{
+	auto rules = std::make_shared<RuleSet>();
+	rules->mode = GetMode();
+	Store(rules);
+}
+
+void MessageFilter::SetMode(FilterMode mode)
+{
+	auto rules = std::make_shared<RuleSet>(*std::atomic_load(&m_rules));
+	rules->mode = mode;
+	Store(rules);
+}
+
+FilterMode MessageFilter::GetMode() const
+{
+	return std::atomic_load(&m_rules)->mode;
+}
+
+void MessageFilter::Store(std::shared_ptr<const RuleSet> rules)
+{
+	m_active.store(!rules->rules.empty(), std::memory_order_release);
+	std::atomic_store(&m_rules, std::move(rules));
+}
+
+bool MessageFilter::Accept(yyjson_doc *document)
+{
+	std::shared_ptr<const RuleSet> rules = std::atomic_load(&m_rules);
+
+	bool matched = false;
+
+	if (document)
+	{
+		for (const Rule &rule : rules->rules)
+		{
+			yyjson_val *val = yyjson_doc_ptr_getn(document, rule.pointer.c_str(), rule.pointer.length());
+			if (!val)
+			{
+				continue;
+			}
+
+			if (rule.match == FilterMatch_Prefix)
+			{
+				matched = yyjson_is_str(val) && yyjson_get_len(val) >= rule.text.length()
+					&& memcmp(yyjson_get_str(val), rule.text.data(), rule.text.length()) == 0;
+			}
+			else
+			{
+				matched = ValueEquals(val, rule.value.get(), rule.text);
+			}
+
+			if (matched)
+			{
+				break;
+			}
+		}
+	}
+
+	bool accepted = (rules->mode == FilterMode_Allow) ? matched : !matched;
+
+	if (!accepted)
+	{
+		m_filtered.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	return accepted;
+}
+
+bool MessageFilter::Accept(const std::string &message)
+{
+	YYJsonDocPtr document(yyjson_read(message.c_str(), message.length(), 0));
+	return Accept(document.get());
+}
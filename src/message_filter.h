@@ -0,0 +1,91 @@
+#include "extension.h"
+
+enum FilterMatch
+{
+	FilterMatch_Equals,
+	FilterMatch_Prefix,
+};
+
+enum FilterMode
+{
+	FilterMode_Allow,
+	FilterMode_Deny,
+};
+
+/**
+ * @brief JSON-pointer rules evaluated on the network thread.
+ *
+ * A message matches when any rule matches. In FilterMode_Allow only matching
+ * messages are queued, in FilterMode_Deny matching messages are dropped.
+ * Rules are edited on the game thread by swapping in a new rule set, so the
+ * network threads never wait on a lock.
+ */
+class MessageFilter
+{
+public:
+	/**
+	 * @brief Adds a rule, called on the game thread.
+	 *
+	 * @param pointer JSON pointer, "" for the whole message.
+	 * @param value JSON text compared with yyjson_equals, anything that is not
+	 *              valid JSON is compared as a string. Prefix rules only match strings.
+	 * @return false with error set if the pointer is invalid.
+	 */
+	bool AddRule(const char *pointer, const char *value, FilterMatch match, std::string &error);
+
+	void Clear();
+
+	void SetMode(FilterMode mode);
+	FilterMode GetMode() const;
+
+	bool IsActive() const {
+		return m_active.load(std::memory_order_acquire);
+	}
+
+	/**
+	 * @brief Decides whether a message is queued, called on a network thread.
+	 *
+	 * @param document Parsed message, nullptr if it is not valid JSON.
+	 */
+	bool Accept(yyjson_doc *document);
+
+	/**
+	 * @brief Parses the message and decides whether it is queued, called on a network thread.
+	 */
+	bool Accept(const std::string &message);
+
+	uint64_t GetFiltered() const {
+		return m_filtered.load(std::memory_order_relaxed);
+	}
+
+	/**
+	 * @brief Parses a rule value, nullptr if it is not valid JSON and is compared as a string.
+	 */
+	static std::shared_ptr<yyjson_doc> ParseValue(const char *value);
+
+	/**
+	 * @brief Compares a message value with a rule value returned by ParseValue.
+	 */
+	static bool ValueEquals(yyjson_val *val, yyjson_doc *value, const std::string &text);
+
+private:
+	struct Rule
+	{
+		std::string pointer;
+		FilterMatch match;
+		std::string text;
+		std::shared_ptr<yyjson_doc> value;
+	};
+
+	struct RuleSet
+	{
+		FilterMode mode = FilterMode_Allow;
+		std::vector<Rule> rules;
+	};
+
+	void Store(std::shared_ptr<const RuleSet> rules);
+
+	std::shared_ptr<const RuleSet> m_rules = std::make_shared<RuleSet>();
+	std::atomic<bool> m_active{false};
+	std::atomic<uint64_t> m_filtered{0};
+};
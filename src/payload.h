@@ -0,0 +1,31 @@
+#include "extension.h"
+
+/**
+ * @brief Counts received message payloads.
+ */
+struct PayloadStats
+{
+	std::atomic<uint64_t> messages{0};
+	std::atomic<uint64_t> bytes{0};
+};
+
+extern PayloadStats g_PayloadStats;
+
+/**
+ * @brief Takes the payload of a received message, called in a message callback.
+ *
+ * The transport hands over its buffer, so the payload is moved rather than
+ * copied. Only a message without a buffer behind it is copied.
+ */
+inline std::string TakePayload(const ix::WebSocketMessagePtr &msg)
+{
+	g_PayloadStats.messages.fetch_add(1, std::memory_order_relaxed);
+	g_PayloadStats.bytes.fetch_add(msg->str.length(), std::memory_order_relaxed);
+
+	if (msg->payload)
+	{
+		return std::move(*msg->payload);
+	}
+
+	return msg->str;
+}
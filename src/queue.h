@@ -1,85 +1,73 @@
 #include "extension.h"
 
 /**
- * @brief A thread-safe queue implementation.
+ * @brief A lock-free multi-producer/single-consumer queue.
  * 
- * This class provides a queue that can be safely used across multiple threads.
- * It uses mutex and condition variable for synchronization.
+ * Producers push intrusive nodes onto an atomic stack with a single CAS,
+ * so network threads never block each other or the game thread. The single
+ * consumer detaches the whole stack with one exchange and reverses it,
+ * which yields the pushed items in FIFO order. Since nodes are never popped
+ * one at a time by concurrent consumers, the stack is not subject to ABA.
  * 
- * @tparam T The type of elements stored in the queue.
+ * @tparam T The node type. It must expose a `T *m_pNext` member that is
+ *           owned by the queue while the node is queued.
  */
 template <class T>
-class ThreadSafeQueue {
+class MpscQueue {
 private:
-	std::queue<T> queue;
-	mutable std::mutex mutex;
-	std::condition_variable cond;
+	std::atomic<T *> m_head{nullptr};
+	std::atomic<size_t> m_size{0};
 
 public:
 	/**
 	 * @brief Default constructor.
 	 */
-	ThreadSafeQueue() = default;
+	MpscQueue() = default;
 
 	/**
 	 * @brief Deleted copy constructor to prevent accidental copying.
 	 */
-	ThreadSafeQueue(const ThreadSafeQueue&) = delete;
+	MpscQueue(const MpscQueue&) = delete;
 
 	/**
 	 * @brief Deleted assignment operator to prevent accidental assignment.
 	 */
-	ThreadSafeQueue& operator=(const ThreadSafeQueue&) = delete;
+	MpscQueue& operator=(const MpscQueue&) = delete;
 
 	/**
-	 * @brief Pushes an item onto the queue.
+	 * @brief Pushes an item onto the queue. Safe to call from any thread.
 	 * 
 	 * @param item The item to be pushed.
 	 */
-	void Push(T item) {
-		std::unique_lock<std::mutex> lock(mutex);
-		queue.push(std::move(item));
-		lock.unlock();
-		cond.notify_one();
-	}
+	void Push(T *item) {
+		m_size.fetch_add(1, std::memory_order_relaxed);
 
-	/**
-	 * @brief Tries to pop an item from the queue.
-	 * 
-	 * @param[out] item The popped item, if successful.
-	 * @return true if an item was popped, false if the queue was empty.
-	 */
-	bool TryPop(T& item) {
-		std::unique_lock<std::mutex> lock(mutex);
-		if (queue.empty()) {
-			return false;
-		}
-		item = std::move(queue.front());
-		queue.pop();
-		return true;
+		T *head = m_head.load(std::memory_order_relaxed);
+		do {
+			item->m_pNext = head;
+		} while (!m_head.compare_exchange_weak(head, item, std::memory_order_release, std::memory_order_relaxed));
 	}
 
 	/**
-	 * @brief Waits for an item and pops it from the queue.
-	 * 
-	 * This method will block until an item is available.
+	 * @brief Detaches every queued item. Must only be called by the consumer.
 	 * 
-	 * @return The popped item.
+	 * @return The first item of a singly linked list in push order, or nullptr if the queue was empty.
 	 */
-	T WaitAndPop() {
-		std::unique_lock<std::mutex> lock(mutex);
-		cond.wait(lock, [this] { return !queue.empty(); });
-		T item = std::move(queue.front());
-		queue.pop();
-		return item;
-	}
+	T *PopAll() {
+		T *head = m_head.exchange(nullptr, std::memory_order_acquire);
+		T *list = nullptr;
+		size_t count = 0;
 
-	/**
-	 * @brief Clears all items from the queue.
-	 */
-	void Clear() {
-		std::unique_lock<std::mutex> lock(mutex);
-		queue = std::queue<T>();
+		while (head) {
+			T *next = head->m_pNext;
+			head->m_pNext = list;
+			list = head;
+			head = next;
+			count++;
+		}
+
+		m_size.fetch_sub(count, std::memory_order_relaxed);
+		return list;
 	}
 
 	/**
@@ -88,17 +76,15 @@ public:
 	 * @return true if the queue is empty, false otherwise.
 	 */
 	bool Empty() const {
-		std::lock_guard<std::mutex> lock(mutex);
-		return queue.empty();
+		return m_head.load(std::memory_order_relaxed) == nullptr;
 	}
 
 	/**
-	 * @brief Gets the current size of the queue.
+	 * @brief Gets the approximate number of items in the queue.
 	 * 
 	 * @return The number of items in the queue.
 	 */
 	size_t Size() const {
-		std::lock_guard<std::mutex> lock(mutex);
-		return queue.size();
+		return m_size.load(std::memory_order_relaxed);
 	}
-};
\ No newline at end of file
+};
@@ -0,0 +1,229 @@
+#include "extension.h"
+
+void RateLimiter::SetLimit(size_t count, int periodMs, size_t maxQueued)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	m_capacity = count;
+	m_maxQueued = maxQueued;
+	m_tokens = static_cast<double>(count);
+	m_lastRefill = Scheduler::Clock::now();
+
+	if (count)
+	{
+		m_refillInterval = std::chrono::duration_cast<Scheduler::Clock::duration>(std::chrono::milliseconds(periodMs)) / count;
+	}
+
+	while (m_maxQueued && m_entries.size() > m_maxQueued)
+	{
+		TakeFront();
+		m_dropped.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	if (!m_entries.empty())
+	{
+		ScheduleDrain(Scheduler::Clock::now());
+	}
+}
+
+bool RateLimiter::Submit(const char *data, size_t length, bool binary, const std::string &key)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	bool waiting = m_draining || !m_entries.empty();
+
+	if (!m_capacity && !waiting)
+	{
+		return false;
+	}
+
+	if (m_capacity && !waiting)
+	{
+		Refill(Scheduler::Clock::now());
+		if (m_tokens >= 1.0)
+		{
+			m_tokens -= 1.0;
+			return false;
+		}
+	}
+
+	m_queued.fetch_add(1, std::memory_order_relaxed);
+
+	if (!key.empty())
+	{
+		auto it = m_keys.find(key);
+		if (it != m_keys.end())
+		{
+			it->second->message.assign(data, length);
+			it->second->binary = binary;
+			m_coalesced.fetch_add(1, std::memory_order_relaxed);
+			return true;
+		}
+	}
+
+	if (m_maxQueued && m_entries.size() >= m_maxQueued)
+	{
+		TakeFront();
+		m_dropped.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	m_entries.push_back({std::string(data, length), binary, key});
+	if (!key.empty())
+	{
+		m_keys.emplace(key, std::prev(m_entries.end()));
+	}
+
+	if (!m_draining)
+	{
+		// the next token, or right away once the limit was lifted
+		double missing = m_capacity ? 1.0 - m_tokens : 0.0;
+		ScheduleDrain(m_lastRefill + std::chrono::duration_cast<Scheduler::Clock::duration>(m_refillInterval * missing));
+	}
+
+	return true;
+}
+
+void RateLimiter::Stop()
+{
+	uint64_t timerId = 0;
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_stopped = true;
+		m_entries.clear();
+		m_keys.clear();
+
+		if (m_timerActive)
+		{
+			timerId = m_timerId;
+		}
+	}
+
+	// a running drain sees m_stopped and never reschedules
+	if (timerId)
+	{
+		g_Scheduler.Cancel(timerId);
+	}
+}
+
+size_t RateLimiter::GetPending()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_entries.size();
+}
+
+void RateLimiter::Refill(Scheduler::Clock::time_point now)
+{
+	if (now <= m_lastRefill)
+	{
+		return;
+	}
+
+	m_tokens += static_cast<double>((now - m_lastRefill).count()) / m_refillInterval.count();
+	if (m_tokens > m_capacity)
+	{
+		m_tokens = static_cast<double>(m_capacity);
+	}
+
+	m_lastRefill = now;
+}
+
+void RateLimiter::ScheduleDrain(Scheduler::Clock::time_point when)
+{
+	if (m_timerActive || m_stopped)
+	{
+		return;
+	}
+
+	m_timerActive = true;
+	m_timerId = g_Scheduler.Schedule(when, [this] { Drain(); });
+}
+
+void RateLimiter::Drain()
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+
+	m_timerActive = false;
+	m_draining = true;
+
+	bool retry = false;
+
+	while (!m_entries.empty() && !m_stopped)
+	{
+		if (m_capacity)
+		{
+			Refill(Scheduler::Clock::now());
+			if (m_tokens < 1.0)
+			{
+				break;
+			}
+			m_tokens -= 1.0;
+		}
+
+		Entry entry = TakeFront();
+
+		// sent outside the lock, new messages queue up behind it meanwhile
+		lock.unlock();
+		bool sent = m_client->SendNow(entry.message.data(), entry.message.length(), entry.binary);
+		bool connected = sent || m_client->IsConnected();
+		lock.lock();
+
+		if (!connected)
+		{
+			// keep it for when the connection is back, unless a newer message with its key arrived
+			if (entry.key.empty() || !m_keys.count(entry.key))
+			{
+				m_entries.push_front(std::move(entry));
+				if (!m_entries.front().key.empty())
+				{
+					m_keys.emplace(m_entries.front().key, m_entries.begin());
+				}
+			}
+
+			if (m_capacity)
+			{
+				m_tokens += 1.0;
+			}
+
+			retry = true;
+			break;
+		}
+
+		if (!sent)
+		{
+			m_dropped.fetch_add(1, std::memory_order_relaxed);
+		}
+	}
+
+	m_draining = false;
+
+	if (m_entries.empty())
+	{
+		return;
+	}
+
+	auto now = Scheduler::Clock::now();
+
+	if (retry)
+	{
+		// wait for the reconnect, checking at the refill rate but at most every 100ms
+		ScheduleDrain(now + std::max<Scheduler::Clock::duration>(m_refillInterval, std::chrono::milliseconds(100)));
+	}
+	else
+	{
+		double missing = m_capacity ? 1.0 - m_tokens : 0.0;
+		ScheduleDrain(now + std::chrono::duration_cast<Scheduler::Clock::duration>(m_refillInterval * missing));
+	}
+}
+
+RateLimiter::Entry RateLimiter::TakeFront()
+{
+	Entry entry = std::move(m_entries.front());
+	m_entries.pop_front();
+
+	if (!entry.key.empty())
+	{
+		m_keys.erase(entry.key);
+	}
+
+	return entry;
+}
@@ -0,0 +1,81 @@
+#include "extension.h"
+
+class WebSocketClient;
+
+/**
+ * @brief Token bucket for outgoing messages of one client.
+ *
+ * Up to count messages go out at once, after that one more every
+ * period / count. Excess messages wait in order and are sent from the
+ * scheduler thread as tokens refill. A waiting message with the same
+ * non-empty key as a new one is replaced by it in place, so only the
+ * latest state update goes out.
+ */
+class RateLimiter
+{
+public:
+	explicit RateLimiter(WebSocketClient *client) : m_client(client) {}
+	~RateLimiter() { Stop(); }
+
+	RateLimiter(const RateLimiter&) = delete;
+	RateLimiter& operator=(const RateLimiter&) = delete;
+
+	/**
+	 * @brief Sets the rate, a count of 0 disables the limit and sends what is waiting.
+	 *
+	 * @param maxQueued Waiting messages kept before the oldest is dropped, 0 for unlimited.
+	 */
+	void SetLimit(size_t count, int periodMs, size_t maxQueued);
+
+	/**
+	 * @brief Takes a token, or queues the message if none is left, called on any thread.
+	 *
+	 * @return true if the message was queued and must not be sent now.
+	 */
+	bool Submit(const char *data, size_t length, bool binary, const std::string &key);
+
+	/**
+	 * @brief Drops waiting messages, returns once no message is being sent.
+	 */
+	void Stop();
+
+	size_t GetPending();
+
+	uint64_t GetQueued() const { return m_queued.load(std::memory_order_relaxed); }
+	uint64_t GetCoalesced() const { return m_coalesced.load(std::memory_order_relaxed); }
+	uint64_t GetDropped() const { return m_dropped.load(std::memory_order_relaxed); }
+
+private:
+	struct Entry
+	{
+		std::string message;
+		bool binary;
+		std::string key;
+	};
+
+	void Refill(Scheduler::Clock::time_point now);
+	void ScheduleDrain(Scheduler::Clock::time_point when);
+	void Drain();
+	Entry TakeFront();
+
+	WebSocketClient *m_client;
+
+	std::mutex m_mutex;
+	std::list<Entry> m_entries;
+	std::unordered_map<std::string, std::list<Entry>::iterator> m_keys;
+	bool m_draining = false;
+	bool m_stopped = false;
+
+	size_t m_capacity = 0;
+	size_t m_maxQueued = 0;
+	double m_tokens = 0;
+	Scheduler::Clock::duration m_refillInterval{};
+	Scheduler::Clock::time_point m_lastRefill;
+
+	bool m_timerActive = false;
+	uint64_t m_timerId = 0;
+
+	std::atomic<uint64_t> m_queued{0};
+	std::atomic<uint64_t> m_coalesced{0};
+	std::atomic<uint64_t> m_dropped{0};
+};
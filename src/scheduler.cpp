@@ -0,0 +1,102 @@
+#include "extension.h"
+
+Scheduler::~Scheduler()
+{
+	Shutdown();
+}
+
+uint64_t Scheduler::Schedule(Clock::time_point when, Job job)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	if (!m_thread.joinable())
+	{
+		m_stop = false;
+		m_thread = std::thread(&Scheduler::Run, this);
+	}
+
+	uint64_t id = m_nextId++;
+	auto it = m_jobs.emplace(when, std::make_pair(id, std::move(job)));
+	m_index.emplace(id, it);
+
+	// only the earliest job changes how long the worker sleeps
+	if (it == m_jobs.begin())
+	{
+		m_wakeUp.notify_one();
+	}
+
+	return id;
+}
+
+void Scheduler::Cancel(uint64_t id)
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+
+	auto it = m_index.find(id);
+	if (it != m_index.end())
+	{
+		m_jobs.erase(it->second);
+		m_index.erase(it);
+		return;
+	}
+
+	m_jobDone.wait(lock, [this, id] { return m_running != id; });
+}
+
+void Scheduler::Shutdown()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if (!m_thread.joinable())
+		{
+			return;
+		}
+
+		m_stop = true;
+		m_wakeUp.notify_one();
+	}
+
+	m_thread.join();
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_jobs.clear();
+	m_index.clear();
+}
+
+void Scheduler::Run()
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+
+	while (!m_stop)
+	{
+		if (m_jobs.empty())
+		{
+			m_wakeUp.wait(lock);
+			continue;
+		}
+
+		auto it = m_jobs.begin();
+		if (it->first > Clock::now())
+		{
+			// copied, the job may be cancelled while we wait
+			Clock::time_point when = it->first;
+			m_wakeUp.wait_until(lock, when);
+			continue;
+		}
+
+		uint64_t id = it->second.first;
+		Job job = std::move(it->second.second);
+		m_jobs.erase(it);
+		m_index.erase(id);
+
+		m_running = id;
+		lock.unlock();
+
+		job();
+		job = nullptr;
+
+		lock.lock();
+		m_running = 0;
+		m_jobDone.notify_all();
+	}
+}
@@ -0,0 +1,54 @@
+#include "extension.h"
+
+/**
+ * @brief Runs timed jobs on one shared worker thread.
+ *
+ * Used for work that has to happen off the game thread at a steady rate,
+ * e.g. heartbeats, independent of frame time and server hibernation. Jobs
+ * must be short and never wait on the game thread.
+ */
+class Scheduler
+{
+public:
+	using Clock = std::chrono::steady_clock;
+	using Job = std::function<void()>;
+
+	~Scheduler();
+
+	/**
+	 * @brief Queues a job to run at the given time, starting the worker if needed.
+	 *
+	 * @return Id used to cancel the job, never 0.
+	 */
+	uint64_t Schedule(Clock::time_point when, Job job);
+
+	uint64_t Post(Job job) {
+		return Schedule(Clock::now(), std::move(job));
+	}
+
+	/**
+	 * @brief Removes a pending job, or waits for it to return if it is running.
+	 *
+	 * Must not be called from a job.
+	 */
+	void Cancel(uint64_t id);
+
+	/**
+	 * @brief Drops pending jobs and joins the worker.
+	 */
+	void Shutdown();
+
+private:
+	void Run();
+
+	std::mutex m_mutex;
+	std::condition_variable m_wakeUp;
+	std::condition_variable m_jobDone;
+	std::thread m_thread;
+	bool m_stop = false;
+
+	std::multimap<Clock::time_point, std::pair<uint64_t, Job>> m_jobs;
+	std::unordered_map<uint64_t, decltype(m_jobs)::iterator> m_index;
+	uint64_t m_nextId = 1;
+	uint64_t m_running = 0;
+};
@@ -0,0 +1,119 @@
+#include "extension.h"
+
+void SendBuffer::SetLimit(size_t maxMessages, size_t maxBytes, QueuePolicy policy)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	m_maxMessages = maxMessages;
+	m_maxBytes = maxBytes;
+	m_policy = policy;
+
+	while (m_entries.size() > m_maxMessages || m_bytes > m_maxBytes)
+	{
+		DropFront();
+	}
+}
+
+bool SendBuffer::Hold(ix::WebSocket *webSocket, const char *data, size_t length, bool binary)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	if (!m_maxMessages)
+	{
+		return false;
+	}
+
+	// checked under the lock, a connection that opens after this point is flushed after this message is queued
+	if (!m_flushing && m_entries.empty() && webSocket->getReadyState() == ix::ReadyState::Open)
+	{
+		return false;
+	}
+
+	m_queued.fetch_add(1, std::memory_order_relaxed);
+
+	if (length > m_maxBytes)
+	{
+		m_dropped.fetch_add(1, std::memory_order_relaxed);
+		return true;
+	}
+
+	if (m_policy == QueuePolicy_DropNewest && (m_entries.size() >= m_maxMessages || m_bytes + length > m_maxBytes))
+	{
+		m_dropped.fetch_add(1, std::memory_order_relaxed);
+		return true;
+	}
+
+	while (m_entries.size() >= m_maxMessages || m_bytes + length > m_maxBytes)
+	{
+		DropFront();
+	}
+
+	m_entries.push_back({std::string(data, length), binary});
+	m_bytes += length;
+
+	return true;
+}
+
+void SendBuffer::Flush(ix::WebSocket *webSocket, const std::function<bool(const std::string &message, bool binary)> &send)
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+
+	if (m_flushing)
+	{
+		return;
+	}
+
+	m_flushing = true;
+
+	while (!m_entries.empty())
+	{
+		Entry entry = std::move(m_entries.front());
+		m_entries.pop_front();
+		m_bytes -= entry.message.length();
+
+		// sent outside the lock, new sends queue up behind it meanwhile
+		lock.unlock();
+		bool sent = send(entry.message, entry.binary);
+		bool connected = sent || webSocket->getReadyState() == ix::ReadyState::Open;
+		lock.lock();
+
+		if (!connected)
+		{
+			// closed again, keep it for the next open unless the buffer was shrunk meanwhile
+			if (m_entries.size() < m_maxMessages && m_bytes + entry.message.length() <= m_maxBytes)
+			{
+				m_bytes += entry.message.length();
+				m_entries.push_front(std::move(entry));
+			}
+			else
+			{
+				m_dropped.fetch_add(1, std::memory_order_relaxed);
+			}
+			break;
+		}
+
+		if (!sent)
+		{
+			// the connection took no issue with it, the message itself was refused
+			m_dropped.fetch_add(1, std::memory_order_relaxed);
+			continue;
+		}
+
+		m_flushed.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	m_flushing = false;
+}
+
+size_t SendBuffer::GetPending()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_entries.size();
+}
+
+void SendBuffer::DropFront()
+{
+	m_bytes -= m_entries.front().message.length();
+	m_entries.pop_front();
+	m_dropped.fetch_add(1, std::memory_order_relaxed);
+}
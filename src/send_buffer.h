@@ -0,0 +1,63 @@
+#include "extension.h"
+
+/**
+ * @brief Holds outgoing messages while a WebSocket is not open.
+ *
+ * Sends made while the connection is down, or while earlier buffered
+ * messages are still being flushed, are queued in order and sent again by
+ * Flush() once the connection opens. The buffer is bounded by message count
+ * and total bytes, and the policy decides what is dropped when it is full.
+ */
+class SendBuffer
+{
+public:
+	/**
+	 * @brief Sets the bounds, a maxMessages of 0 disables buffering and drops what is queued.
+	 *
+	 * Only QueuePolicy_DropOldest and QueuePolicy_DropNewest apply.
+	 */
+	void SetLimit(size_t maxMessages, size_t maxBytes, QueuePolicy policy);
+
+	/**
+	 * @brief Queues the message unless it can be sent right away, called on any thread.
+	 *
+	 * @return true if the message was taken by the buffer and must not be sent now.
+	 */
+	bool Hold(ix::WebSocket *webSocket, const char *data, size_t length, bool binary);
+
+	/**
+	 * @brief Passes queued messages to send in order, called on the network thread once the connection opens.
+	 *
+	 * Stops at the first message send fails on once the connection closed and keeps it for the
+	 * next open, a message that fails while the connection is still open is dropped instead.
+	 */
+	void Flush(ix::WebSocket *webSocket, const std::function<bool(const std::string &message, bool binary)> &send);
+
+	size_t GetPending();
+
+	uint64_t GetQueued() const { return m_queued.load(std::memory_order_relaxed); }
+	uint64_t GetFlushed() const { return m_flushed.load(std::memory_order_relaxed); }
+	uint64_t GetDropped() const { return m_dropped.load(std::memory_order_relaxed); }
+
+private:
+	struct Entry
+	{
+		std::string message;
+		bool binary;
+	};
+
+	void DropFront();
+
+	std::mutex m_mutex;
+	std::deque<Entry> m_entries;
+	size_t m_bytes = 0;
+	bool m_flushing = false;
+
+	size_t m_maxMessages = 0;
+	size_t m_maxBytes = 0;
+	QueuePolicy m_policy = QueuePolicy_DropOldest;
+
+	std::atomic<uint64_t> m_queued{0};
+	std::atomic<uint64_t> m_flushed{0};
+	std::atomic<uint64_t> m_dropped{0};
+};
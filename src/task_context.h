@@ -1,6 +1,55 @@
+enum TaskLane
+{
+	TaskLane_Control,	// open, close, error and drop notifications
+	TaskLane_Http,		// HTTP responses
+	TaskLane_Data,		// WebSocket messages
+
+	TaskLane_Count
+};
+
 class ITaskContext
 {
 public:
 	virtual void OnCompleted() = 0;
 	virtual ~ITaskContext() {}
-};
\ No newline at end of file
+
+	/**
+	 * @brief Whatever the task reports to is gone, it is deleted without running.
+	 */
+	virtual bool IsStale() const { return false; }
+
+	/**
+	 * @brief Called by the dispatcher once the task leaves its lane, it is deleted afterwards.
+	 */
+	virtual void Run() {
+		if (!IsStale()) OnCompleted();
+	}
+
+	// intrusive link used by the task queue
+	ITaskContext *m_pNext = nullptr;
+};
+
+/**
+ * @brief Base for task contexts allocated from a per-type TaskPool.
+ *
+ * Tasks are created with new on network threads and deleted on the game
+ * thread; routing both through the pool hands the memory back to the
+ * producing thread instead of going through the global allocator.
+ *
+ * @tparam T    The concrete task context type.
+ * @tparam Base The task base it derives from.
+ */
+template <class T, class Base = ITaskContext>
+class PooledTaskContext : public Base
+{
+public:
+	using Base::Base;
+
+	static void *operator new(size_t size) {
+		return TaskPool<T>::New(size);
+	}
+
+	static void operator delete(void *ptr) {
+		TaskPool<T>::Delete(ptr);
+	}
+};
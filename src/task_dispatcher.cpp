@@ -0,0 +1,136 @@
+#include "extension.h"
+
+TaskDispatcher::TaskDispatcher()
+{
+	m_lanes[TaskLane_Control].weight = 16;
+	m_lanes[TaskLane_Http].weight = 4;
+	m_lanes[TaskLane_Data].weight = 1;
+}
+
+void TaskDispatcher::SetLaneWeight(TaskLane lane, int weight)
+{
+	m_lanes[lane].weight = weight < 1 ? 1 : weight;
+}
+
+void TaskDispatcher::SetBudget(int budgetUs, int minTasks, bool adaptive)
+{
+	m_budgetUs = budgetUs < 0 ? 0 : budgetUs;
+	m_minTasks = minTasks < 1 ? 1 : minTasks;
+	m_adaptive = adaptive;
+}
+
+size_t TaskDispatcher::GetPending() const
+{
+	size_t pending = 0;
+
+	for (int lane = 0; lane < TaskLane_Count; lane++)
+	{
+		pending += GetPending(static_cast<TaskLane>(lane));
+	}
+
+	return pending;
+}
+
+size_t TaskDispatcher::GetPending(TaskLane lane) const
+{
+	return m_lanes[lane].backlogSize + g_TaskQueues[lane].Size();
+}
+
+ITaskContext *TaskDispatcher::PopFromLane(TaskLane lane)
+{
+	Lane &state = m_lanes[lane];
+
+	if (!state.pBacklog)
+	{
+		state.pBacklog = g_TaskQueues[lane].PopAll();
+
+		for (ITaskContext *it = state.pBacklog; it; it = it->m_pNext)
+		{
+			state.backlogSize++;
+		}
+	}
+
+	ITaskContext *context = state.pBacklog;
+
+	if (context)
+	{
+		state.pBacklog = context->m_pNext;
+		context->m_pNext = nullptr;
+		state.backlogSize--;
+	}
+
+	return context;
+}
+
+ITaskContext *TaskDispatcher::PopTask()
+{
+	// the current lane, then every lane once more before giving up
+	for (int i = 0; i <= TaskLane_Count; i++)
+	{
+		if (m_laneCredit > 0)
+		{
+			ITaskContext *context = PopFromLane(m_currentLane);
+
+			if (context)
+			{
+				m_laneCredit--;
+				return context;
+			}
+		}
+
+		m_currentLane = static_cast<TaskLane>((m_currentLane + 1) % TaskLane_Count);
+		m_laneCredit = m_lanes[m_currentLane].weight;
+	}
+
+	return nullptr;
+}
+
+void TaskDispatcher::RunFrame()
+{
+	using clock = std::chrono::steady_clock;
+
+	const auto frameStart = clock::now();
+	auto taskStart = frameStart;
+	size_t count = 0;
+
+	m_currentLane = TaskLane_Control;
+	m_laneCredit = m_lanes[TaskLane_Control].weight;
+
+	while (true)
+	{
+		if (count >= static_cast<size_t>(m_minTasks))
+		{
+			// a zero budget keeps the old fixed-count behaviour
+			if (m_budgetUs == 0)
+			{
+				break;
+			}
+
+			double elapsedUs = std::chrono::duration<double, std::micro>(taskStart - frameStart).count();
+			double predictedUs = m_adaptive ? m_avgCostUs : 0.0;
+
+			if (elapsedUs + predictedUs >= m_budgetUs)
+			{
+				break;
+			}
+		}
+
+		ITaskContext *context = PopTask();
+
+		if (!context)
+		{
+			break;
+		}
+
+		context->Run();
+		delete context;
+		count++;
+
+		auto taskEnd = clock::now();
+		double costUs = std::chrono::duration<double, std::micro>(taskEnd - taskStart).count();
+		m_avgCostUs += (costUs - m_avgCostUs) * kCostSmoothing;
+		taskStart = taskEnd;
+	}
+
+	m_lastProcessed = count;
+}
@@ -0,0 +1,72 @@
+#include "extension.h"
+
+/**
+ * @brief Drains queued network events on the game thread.
+ *
+ * Instead of a fixed number of tasks per frame, the dispatcher runs tasks
+ * until a per-frame time budget is spent. A minimum number of tasks is always
+ * processed so progress is guaranteed even when single callbacks are expensive.
+ * In adaptive mode the dispatcher keeps a moving average of recent callback
+ * cost and stops early when the next callback is predicted to overrun the budget.
+ *
+ * Tasks are queued in priority lanes. Every frame starts with the control lane
+ * and the lanes are visited round robin, taking up to the lane's weight in
+ * tasks before moving on, so control events never wait behind bulk messages.
+ */
+class TaskDispatcher
+{
+public:
+	static constexpr int kDefaultBudgetUs = 1000;
+	static constexpr int kDefaultMinTasks = 10;
+
+	TaskDispatcher();
+
+	/**
+	 * @brief Processes queued tasks for the current frame.
+	 */
+	void RunFrame();
+
+	void SetBudget(int budgetUs, int minTasks, bool adaptive);
+
+	void SetLaneWeight(TaskLane lane, int weight);
+	int GetLaneWeight(TaskLane lane) const { return m_lanes[lane].weight; }
+
+	int GetBudget() const { return m_budgetUs; }
+	int GetMinTasks() const { return m_minTasks; }
+	bool IsAdaptive() const { return m_adaptive; }
+	double GetAverageCost() const { return m_avgCostUs; }
+	size_t GetLastProcessed() const { return m_lastProcessed; }
+
+	/**
+	 * @brief Gets the number of tasks waiting to run, including tasks already detached from the queue.
+	 */
+	size_t GetPending() const;
+	size_t GetPending(TaskLane lane) const;
+
+private:
+	ITaskContext *PopTask();
+	ITaskContext *PopFromLane(TaskLane lane);
+
+	// weight of the newest sample in the callback cost moving average
+	static constexpr double kCostSmoothing = 0.1;
+
+	int m_budgetUs = kDefaultBudgetUs;
+	int m_minTasks = kDefaultMinTasks;
+	bool m_adaptive = false;
+
+	double m_avgCostUs = 0.0;
+	size_t m_lastProcessed = 0;
+
+	struct Lane
+	{
+		int weight;
+
+		// tasks detached from the lane queue in one batch but not yet run
+		ITaskContext *pBacklog = nullptr;
+		size_t backlogSize = 0;
+	};
+
+	Lane m_lanes[TaskLane_Count];
+	TaskLane m_currentLane = TaskLane_Control;
+	int m_laneCredit = 0;
+};
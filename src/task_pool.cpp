@@ -0,0 +1,129 @@
+#include "extension.h"
+
+std::atomic<TaskPoolBase *> TaskPoolBase::s_pools{nullptr};
+
+TaskPoolBase::TaskPoolBase()
+{
+	TaskPoolBase *head = s_pools.load(std::memory_order_relaxed);
+	do {
+		m_pNextPool = head;
+	} while (!s_pools.compare_exchange_weak(head, this, std::memory_order_release, std::memory_order_relaxed));
+}
+
+void TaskPoolBase::GetTotals(uint64_t &hits, uint64_t &misses)
+{
+	hits = 0;
+	misses = 0;
+
+	for (TaskPoolBase *pool = s_pools.load(std::memory_order_acquire); pool; pool = pool->m_pNextPool)
+	{
+		hits += pool->m_hits.load(std::memory_order_relaxed);
+		misses += pool->m_misses.load(std::memory_order_relaxed);
+	}
+}
+
+void *TaskPoolBase::Allocate(TaskPoolCache *&cache, size_t blockSize, size_t size)
+{
+	TaskPoolBlock *block;
+
+	// a subclass larger than the pooled type, don't cache it
+	if (size > blockSize)
+	{
+		block = static_cast<TaskPoolBlock *>(::operator new(sizeof(TaskPoolBlock) + size));
+		block->m_pOwner = nullptr;
+		m_misses.fetch_add(1, std::memory_order_relaxed);
+		return block + 1;
+	}
+
+	if (!cache)
+	{
+		cache = AcquireCache();
+	}
+
+	if (!cache->m_pFree)
+	{
+		TaskPoolBlock *returned = cache->m_returned.exchange(nullptr, std::memory_order_acquire);
+
+		while (returned)
+		{
+			TaskPoolBlock *next = returned->m_pNext;
+
+			if (cache->m_freeCount < kMaxCachedBlocks)
+			{
+				returned->m_pNext = cache->m_pFree;
+				cache->m_pFree = returned;
+				cache->m_freeCount++;
+			}
+			else
+			{
+				::operator delete(returned);
+			}
+
+			returned = next;
+		}
+	}
+
+	block = cache->m_pFree;
+
+	if (block)
+	{
+		cache->m_pFree = block->m_pNext;
+		cache->m_freeCount--;
+		m_hits.fetch_add(1, std::memory_order_relaxed);
+	}
+	else
+	{
+		block = static_cast<TaskPoolBlock *>(::operator new(sizeof(TaskPoolBlock) + blockSize));
+		block->m_pOwner = cache;
+		m_misses.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	return block + 1;
+}
+
+void TaskPoolBase::Free(void *ptr)
+{
+	if (!ptr)
+	{
+		return;
+	}
+
+	TaskPoolBlock *block = static_cast<TaskPoolBlock *>(ptr) - 1;
+	TaskPoolCache *owner = block->m_pOwner;
+
+	if (!owner)
+	{
+		::operator delete(block);
+		return;
+	}
+
+	TaskPoolBlock *head = owner->m_returned.load(std::memory_order_relaxed);
+	do {
+		block->m_pNext = head;
+	} while (!owner->m_returned.compare_exchange_weak(head, block, std::memory_order_release, std::memory_order_relaxed));
+}
+
+TaskPoolCache *TaskPoolBase::AcquireCache()
+{
+	std::lock_guard<std::mutex> lock(m_cachesMutex);
+
+	// adopt a cache left behind by a thread that has exited
+	for (const auto& cache : m_caches)
+	{
+		if (!cache->m_inUse)
+		{
+			cache->m_inUse = true;
+			return cache.get();
+		}
+	}
+
+	m_caches.push_back(std::make_unique<TaskPoolCache>());
+	m_caches.back()->m_inUse = true;
+	return m_caches.back().get();
+}
+
+void TaskPoolBase::ReleaseCache(TaskPoolCache *cache)
+{
+	std::lock_guard<std::mutex> lock(m_cachesMutex);
+	cache->m_inUse = false;
+}
@@ -0,0 +1,105 @@
+#include "extension.h"
+
+/**
+ * @brief Header placed in front of every pooled allocation.
+ */
+struct alignas(alignof(std::max_align_t)) TaskPoolBlock
+{
+	TaskPoolBlock *m_pNext;
+	struct TaskPoolCache *m_pOwner;
+};
+
+/**
+ * @brief Free list owned by a single producer thread.
+ *
+ * Only the owning thread touches m_pFree. Blocks freed on other threads
+ * (normally the game thread) are pushed onto m_returned and picked up by
+ * the owner in one exchange the next time its private list runs dry, so a
+ * block always goes back to the thread that allocated it.
+ */
+struct TaskPoolCache
+{
+	TaskPoolBlock *m_pFree = nullptr;
+	size_t m_freeCount = 0;
+	std::atomic<TaskPoolBlock *> m_returned{nullptr};
+	bool m_inUse = false;
+};
+
+/**
+ * @brief Type-independent part of a task pool, used for statistics.
+ */
+class TaskPoolBase
+{
+public:
+	TaskPoolBase();
+
+	TaskPoolBase(const TaskPoolBase&) = delete;
+	TaskPoolBase& operator=(const TaskPoolBase&) = delete;
+
+	/**
+	 * @brief Sums hit and miss counters over every task pool.
+	 */
+	static void GetTotals(uint64_t &hits, uint64_t &misses);
+
+	std::atomic<uint64_t> m_hits{0};
+	std::atomic<uint64_t> m_misses{0};
+
+protected:
+	// blocks kept per thread before extra ones are handed back to the allocator
+	static constexpr size_t kMaxCachedBlocks = 1024;
+
+	void *Allocate(TaskPoolCache *&cache, size_t blockSize, size_t size);
+	static void Free(void *ptr);
+
+	TaskPoolCache *AcquireCache();
+	void ReleaseCache(TaskPoolCache *cache);
+
+private:
+	std::mutex m_cachesMutex;
+	std::vector<std::unique_ptr<TaskPoolCache>> m_caches;
+	TaskPoolBase *m_pNextPool = nullptr;
+
+	static std::atomic<TaskPoolBase *> s_pools;
+};
+
+/**
+ * @brief Per-type object pool with thread-cached free lists.
+ *
+ * Each producer thread leases its own TaskPoolCache the first time it
+ * allocates a T and gives it back when the thread exits, so the next
+ * thread can adopt the cached blocks.
+ *
+ * @tparam T The pooled type.
+ */
+template <class T>
+class TaskPool : public TaskPoolBase
+{
+public:
+	static void *New(size_t size) {
+		return s_instance.Allocate(s_lease.m_pCache, sizeof(T), size);
+	}
+
+	static void Delete(void *ptr) {
+		Free(ptr);
+	}
+
+private:
+	class CacheLease
+	{
+	public:
+		~CacheLease() {
+			if (m_pCache) s_instance.ReleaseCache(m_pCache);
+		}
+
+		TaskPoolCache *m_pCache = nullptr;
+	};
+
+	static TaskPool s_instance;
+	static thread_local CacheLease s_lease;
+};
+
+template <class T>
+TaskPool<T> TaskPool<T>::s_instance;
+
+template <class T>
+thread_local typename TaskPool<T>::CacheLease TaskPool<T>::s_lease;
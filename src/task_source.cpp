@@ -0,0 +1,239 @@
+#include "extension.h"
+
+TaskSource::~TaskSource()
+{
+	m_link->source = nullptr;
+	Interrupt();
+
+	if (pDropForward) forwards->ReleaseForward(pDropForward);
+}
+
+void TaskSource::Queue(SourceTask *context, TaskLane lane)
+{
+	{
+		std::lock_guard<std::mutex> lock(m_link->mutex);
+		m_link->waiting.push_back(context);
+		context->m_waiting = true;
+	}
+
+	g_WebsocketExt.AddTaskToQueue(context, lane);
+}
+
+void TaskSource::SetQueueLimit(size_t maxDepth, QueuePolicy policy)
+{
+	m_maxDepth.store(maxDepth, std::memory_order_relaxed);
+	m_policy.store(policy, std::memory_order_relaxed);
+
+	// a raised limit or a different policy may release paused threads
+	NotifyWaiters();
+}
+
+bool TaskSource::Admit(uint64_t &seq)
+{
+	seq = m_seq.fetch_add(1, std::memory_order_relaxed) + 1;
+
+	size_t maxDepth = m_maxDepth.load(std::memory_order_relaxed);
+
+	if (!maxDepth)
+	{
+		m_live.fetch_add(1, std::memory_order_release);
+		return true;
+	}
+
+	if (Reserve(maxDepth))
+	{
+		return true;
+	}
+
+	switch (m_policy.load(std::memory_order_relaxed))
+	{
+		case QueuePolicy_DropNewest:
+		{
+			ReportDrop(1);
+			return false;
+		}
+		case QueuePolicy_DropOldest:
+		{
+			// the new task takes the place of the oldest one, m_live is unchanged
+			m_skip.fetch_add(1, std::memory_order_release);
+			ReportDrop(1);
+			return true;
+		}
+		case QueuePolicy_Coalesce:
+		{
+			uint64_t superseded = m_supersededBefore.load(std::memory_order_relaxed);
+			while (superseded < seq && !m_supersededBefore.compare_exchange_weak(superseded, seq, std::memory_order_release, std::memory_order_relaxed)) {}
+
+			size_t dropped = m_live.exchange(1, std::memory_order_acq_rel);
+			m_skip.store(0, std::memory_order_release);
+			ReportDrop(dropped);
+			return true;
+		}
+		case QueuePolicy_Pause:
+		{
+			std::unique_lock<std::mutex> lock(m_waitMutex);
+			bool reserved = false;
+			m_waiters++;
+			m_waitCond.wait(lock, [this, &reserved] {
+				size_t limit = m_maxDepth.load(std::memory_order_relaxed);
+				if (m_interrupted || !limit || m_policy.load(std::memory_order_relaxed) != QueuePolicy_Pause)
+				{
+					return true;
+				}
+
+				reserved = Reserve(limit);
+				return reserved;
+			});
+			m_waiters--;
+
+			if (!reserved)
+			{
+				m_live.fetch_add(1, std::memory_order_release);
+			}
+			return true;
+		}
+	}
+
+	m_live.fetch_add(1, std::memory_order_release);
+	return true;
+}
+
+bool TaskSource::Reserve(size_t maxDepth)
+{
+	// several network threads may feed the source, the check and the increment must be one step
+	size_t live = m_live.load(std::memory_order_acquire);
+	while (live < maxDepth)
+	{
+		if (m_live.compare_exchange_weak(live, live + 1, std::memory_order_acq_rel, std::memory_order_acquire))
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+bool TaskSource::Consume(uint64_t seq)
+{
+	if (seq < m_supersededBefore.load(std::memory_order_acquire))
+	{
+		return false;
+	}
+
+	if (m_skip.load(std::memory_order_acquire) > 0)
+	{
+		m_skip.fetch_sub(1, std::memory_order_acq_rel);
+		return false;
+	}
+
+	// saturate, a concurrent coalesce may already have reset the count
+	size_t live = m_live.load(std::memory_order_acquire);
+	while (live && !m_live.compare_exchange_weak(live, live - 1, std::memory_order_acq_rel, std::memory_order_acquire)) {}
+
+	NotifyWaiters();
+
+	return true;
+}
+
+void TaskSource::NotifyWaiters()
+{
+	if (m_waiters.load(std::memory_order_acquire) > 0)
+	{
+		std::lock_guard<std::mutex> lock(m_waitMutex);
+		m_waitCond.notify_all();
+	}
+}
+
+void TaskSource::Interrupt()
+{
+	std::lock_guard<std::mutex> lock(m_waitMutex);
+	m_interrupted = true;
+	m_waitCond.notify_all();
+}
+
+void TaskSource::Resume()
+{
+	std::lock_guard<std::mutex> lock(m_waitMutex);
+	m_interrupted = false;
+}
+
+void TaskSource::ReportDrop(size_t count)
+{
+	if (!count)
+	{
+		return;
+	}
+
+	m_dropped.fetch_add(count, std::memory_order_relaxed);
+
+	if (!pDropForward || !pDropForward->GetFunctionCount())
+	{
+		return;
+	}
+
+	if (!m_dropReportPending.exchange(true, std::memory_order_acq_rel))
+	{
+		Queue(new SourceDropTaskContext(this), TaskLane_Control);
+	}
+}
+
+void TaskSource::OnDropReported()
+{
+	m_dropReportPending.store(false, std::memory_order_release);
+
+	size_t dropped = m_dropped.exchange(0, std::memory_order_relaxed);
+
+	if (!dropped || !pDropForward)
+	{
+		return;
+	}
+
+	pDropForward->PushCell(GetSourceHandle());
+	pDropForward->PushCell(static_cast<cell_t>(dropped));
+	pDropForward->Execute(nullptr);
+}
+
+void SourceDropTaskContext::OnCompleted()
+{
+	m_source->OnDropReported();
+}
+
+SourceTask::~SourceTask()
+{
+	std::lock_guard<std::mutex> lock(m_link->mutex);
+
+	// deleted without running
+	if (m_waiting)
+	{
+		std::deque<SourceTask *> &waiting = m_link->waiting;
+		waiting.erase(std::find(waiting.begin(), waiting.end(), this));
+	}
+}
+
+void SourceTask::Run()
+{
+	std::unique_lock<std::mutex> lock(m_link->mutex);
+
+	// already run by a later task of the source
+	if (!m_waiting)
+	{
+		return;
+	}
+
+	SourceTask *task;
+	do
+	{
+		task = m_link->waiting.front();
+		m_link->waiting.pop_front();
+		task->m_waiting = false;
+
+		// callbacks may queue tasks of the same source
+		lock.unlock();
+		if (!task->IsStale())
+		{
+			task->OnCompleted();
+		}
+		lock.lock();
+	}
+	while (task != this);
+}
@@ -0,0 +1,183 @@
+#include "extension.h"
+
+enum QueuePolicy
+{
+	QueuePolicy_DropOldest,
+	QueuePolicy_DropNewest,
+	QueuePolicy_Coalesce,
+	QueuePolicy_Pause,
+};
+
+class TaskSource;
+class SourceTask;
+
+/**
+ * @brief Shared by a source and the tasks it queued, which may outlive it.
+ */
+struct TaskSourceLink
+{
+	// cleared when the source is deleted, only read and written on the game thread
+	TaskSource *source = nullptr;
+
+	std::mutex mutex;
+	// queued tasks of the source that did not run yet, in the order they were queued
+	std::deque<SourceTask *> waiting;
+};
+
+/**
+ * @brief Bounds the number of data tasks a single WebSocket, WebSocketServer
+ * or HttpRequest may have waiting in g_TaskQueue.
+ *
+ * Network threads call Admit() before queueing a data task and the game
+ * thread calls Consume() before running it. When the limit is reached the
+ * configured policy decides what happens:
+ *  - DropOldest: the oldest waiting task is discarded when it reaches the front.
+ *  - DropNewest: the incoming task is discarded.
+ *  - Coalesce:   every waiting task is superseded by the incoming one.
+ *  - Pause:      the network thread blocks, which stops reading from the socket
+ *                until the game thread catches up.
+ * Dropped tasks are counted and reported through the drop forward.
+ *
+ * Notifications go to the control lane and data tasks to the data lane, but
+ * a task first runs every task its source queued before it, so the plugin
+ * still sees the events of a source in the order they happened.
+ */
+class TaskSource
+{
+public:
+	TaskSource(TaskLane dataLane = TaskLane_Data) : m_dataLane(dataLane) { m_link->source = this; }
+	virtual ~TaskSource();
+
+	/**
+	 * @brief Queues a task of this source in a lane, from any thread.
+	 */
+	void Queue(SourceTask *context, TaskLane lane);
+
+	const std::shared_ptr<TaskSourceLink> &GetLink() const { return m_link; }
+
+	/**
+	 * @brief Handle passed as the first parameter of the drop forward.
+	 */
+	virtual Handle_t GetSourceHandle() = 0;
+
+	void SetQueueLimit(size_t maxDepth, QueuePolicy policy);
+
+	/**
+	 * @brief Called on a network thread before queueing a data task.
+	 *
+	 * @param[out] seq Sequence number to pass back to Consume().
+	 * @return false if the task must not be queued.
+	 */
+	bool Admit(uint64_t &seq);
+
+	/**
+	 * @brief Called on the game thread before running a data task.
+	 *
+	 * @return false if the task was dropped and its callback must be skipped.
+	 */
+	bool Consume(uint64_t seq);
+
+	/**
+	 * @brief Wakes network threads blocked by the pause policy, so the
+	 * connection can be stopped from the game thread.
+	 */
+	void Interrupt();
+
+	/**
+	 * @brief Re-enables the pause policy after Interrupt().
+	 */
+	void Resume();
+
+	void ReportDrop(size_t count);
+	void OnDropReported();
+
+	size_t GetQueued() const { return m_live.load(std::memory_order_relaxed); }
+
+	/**
+	 * @brief Lane for data tasks, high priority sources share the control lane.
+	 */
+	TaskLane GetDataLane() const { return m_highPriority.load(std::memory_order_relaxed) ? TaskLane_Control : m_dataLane; }
+
+	void SetHighPriority(bool highPriority) { m_highPriority.store(highPriority, std::memory_order_relaxed); }
+	bool IsHighPriority() const { return m_highPriority.load(std::memory_order_relaxed); }
+
+	IChangeableForward *pDropForward = nullptr;
+
+private:
+	// takes a slot below maxDepth, false if the source is full
+	bool Reserve(size_t maxDepth);
+	void NotifyWaiters();
+
+	const TaskLane m_dataLane;
+	std::atomic<bool> m_highPriority{false};
+
+	std::shared_ptr<TaskSourceLink> m_link = std::make_shared<TaskSourceLink>();
+
+	std::atomic<size_t> m_maxDepth{0};
+	std::atomic<int> m_policy{QueuePolicy_DropOldest};
+
+	// tasks that will still be delivered
+	std::atomic<size_t> m_live{0};
+	// oldest waiting tasks to discard (DropOldest)
+	std::atomic<size_t> m_skip{0};
+	// waiting tasks below this sequence number are superseded (Coalesce)
+	std::atomic<uint64_t> m_supersededBefore{0};
+	std::atomic<uint64_t> m_seq{0};
+
+	std::atomic<size_t> m_dropped{0};
+	std::atomic<bool> m_dropReportPending{false};
+
+	std::mutex m_waitMutex;
+	std::condition_variable m_waitCond;
+	std::atomic<int> m_waiters{0};
+	bool m_interrupted = false;
+};
+
+/**
+ * @brief Base for the tasks of a TaskSource.
+ *
+ * The tasks of a source are spread over several lanes, so running one first
+ * runs the tasks its source queued before it. Those are deleted unrun once
+ * they leave their own lane. Tasks still queued when their source is deleted
+ * are dropped unrun.
+ */
+class SourceTask : public ITaskContext
+{
+public:
+	SourceTask(TaskSource *source) : m_link(source->GetLink()) {}
+	virtual ~SourceTask();
+
+	virtual bool IsStale() const override { return !m_link->source; }
+	virtual void Run() override;
+
+private:
+	friend class TaskSource;
+
+	std::shared_ptr<TaskSourceLink> m_link;
+	// in m_link->waiting, guarded by its mutex
+	bool m_waiting = false;
+};
+
+/**
+ * @brief Base for the task contexts of a TaskSource.
+ *
+ * @tparam T The concrete task context type.
+ */
+template <class T>
+class SourceTaskContext : public PooledTaskContext<T, SourceTask>
+{
+public:
+	SourceTaskContext(TaskSource *source) : PooledTaskContext<T, SourceTask>(source) {}
+};
+
+class SourceDropTaskContext : public SourceTaskContext<SourceDropTaskContext>
+{
+public:
+	SourceDropTaskContext(TaskSource* source) 
+		: SourceTaskContext(source), m_source(source) {}
+	
+	virtual void OnCompleted() override;
+	
+private:
+	TaskSource* m_source;
+};
@@ -1,6 +1,7 @@
 #include "extension.h"
 
-WebSocketClient::WebSocketClient(ix::WebSocket* existingSocket) : m_webSocket(existingSocket) {}
+WebSocketClient::WebSocketClient(std::shared_ptr<ix::WebSocket> serverSocket)
+	: m_webSocket(serverSocket.get()), m_serverSocket(std::move(serverSocket)), m_keepConnecting(true) {}
 
 WebSocketClient::WebSocketClient(const char* url, uint8_t type) 
 {
@@ -14,12 +15,14 @@ WebSocketClient::WebSocketClient(const char* url, uint8_t type)
 		{
 			case ix::WebSocketMessageType::Message:
 			{
-				OnMessage(msg->str);
+				m_stats.OnReceived(msg->wireSize);
+				msg->binary ? OnBinaryMessage(TakePayload(msg)) : OnMessage(TakePayload(msg));
 				break;
 			}
 			case ix::WebSocketMessageType::Open:
 			{
 				m_headers = msg->openInfo.headers;
+				m_stats.OnOpen();
 				OnOpen(msg->openInfo);
 				break;
 			}
@@ -39,12 +42,20 @@ WebSocketClient::WebSocketClient(const char* url, uint8_t type)
 
 WebSocketClient::~WebSocketClient() 
 {
+	m_heartbeat.Stop();
+	m_jsonWriter.Cancel();
+	m_rateLimiter.Stop();
+	Interrupt();
+
 	if (!m_keepConnecting) m_webSocket->stop();
 
 	if (pMessageForward) forwards->ReleaseForward(pMessageForward);
 	if (pOpenForward) forwards->ReleaseForward(pOpenForward);
 	if (pCloseForward) forwards->ReleaseForward(pCloseForward);
 	if (pErrorForward) forwards->ReleaseForward(pErrorForward);
+	if (pBatchForward) forwards->ReleaseForward(pBatchForward);
+	if (pBinaryForward) forwards->ReleaseForward(pBinaryForward);
+	if (pHeartbeatForward) forwards->ReleaseForward(pHeartbeatForward);
 }
 
 bool WebSocketClient::IsConnected()
@@ -52,26 +63,185 @@ bool WebSocketClient::IsConnected()
 	return m_webSocket->getReadyState() == ix::ReadyState::Open;
 }
 
-void WebSocketClient::OnMessage(const std::string& message) 
+bool WebSocketClient::Send(const char* data, size_t length, bool binary, const std::string& key)
+{
+	// the check WebSocket::sendText does, without copying the text into a string, made before
+	// anything is buffered so a text that can never be sent does not hold up the ones behind it
+	if (!binary)
+	{
+		ix::Utf8Validator validator;
+		if (!validator.decode(data, data + length) || !validator.complete())
+		{
+			return false;
+		}
+	}
+
+	if (m_sendBuffer.Hold(m_webSocket, data, length, binary) || m_rateLimiter.Submit(data, length, binary, key))
+	{
+		return true;
+	}
+
+	return SendNow(data, length, binary);
+}
+
+bool WebSocketClient::SendNow(const char* data, size_t length, bool binary)
+{
+	ix::IXWebSocketSendData payload(data, length);
+	ix::WebSocketSendInfo info;
+
+	if (binary)
+	{
+		info = m_webSocket->sendBinary(payload);
+		m_stats.OnSent(info);
+		return info.success;
+	}
+
+	info = m_webSocket->sendUtf8Text(payload);
+	m_stats.OnSent(info);
+	return info.success;
+}
+
+void WebSocketClient::OnMessage(std::string&& message) 
+{
+	bool batched = pBatchForward && pBatchForward->GetFunctionCount();
+	bool delivered = batched || (pMessageForward && pMessageForward->GetFunctionCount());
+	bool observed = m_heartbeat.IsObserving();
+
+	if (!delivered && !observed)
+	{
+		return;
+	}
+
+	bool json = m_callback_type == WebSocket_JSON;
+	bool filtered = m_filter.IsActive();
+
+	// parsed once on the network thread, for the heartbeat, the filter and WebSocket_JSON clients
+	YYJsonDocPtr document;
+	std::string parseError;
+
+	if (json || filtered || observed)
+	{
+		document = ParseMessage(message, parseError);
+	}
+
+	// the heartbeat sees every message, including the ones filtered out below
+	int rtt;
+	if (observed && m_heartbeat.Observe(document.get(), rtt))
+	{
+		m_heartbeat.Report(rtt);
+	}
+
+	if (!delivered || (filtered && !m_filter.Accept(document.get())))
+	{
+		return;
+	}
+
+	uint64_t seq;
+	if (!Admit(seq))
+	{
+		return;
+	}
+
+	if (batched)
+	{
+		BatchedMessage entry;
+		entry.seq = seq;
+
+		if (json)
+		{
+			entry.document = std::move(document);
+			entry.parseError = parseError;
+		}
+		else
+		{
+			entry.message = std::move(message);
+		}
+
+		if (m_batch.Add(std::move(entry)))
+		{
+			WsBatchTaskContext *context = new WsBatchTaskContext(this);
+			Queue(context, GetDataLane());
+		}
+		return;
+	}
+
+	WsMessageTaskContext *context;
+
+	if (json)
+	{
+		context = new WsMessageTaskContext(this, std::move(document), parseError, message.length(), seq);
+	}
+	else
+	{
+		context = new WsMessageTaskContext(this, std::move(message), seq);
+	}
+
+	Queue(context, GetDataLane());
+}
+
+void WebSocketClient::OnBinaryMessage(std::string&& message) 
+{
+	// without a binary callback, binary frames are delivered like text
+	if (!pBinaryForward || !pBinaryForward->GetFunctionCount())
+	{
+		OnMessage(std::move(message));
+		return;
+	}
+
+	uint64_t seq;
+	if (!Admit(seq))
+	{
+		return;
+	}
+
+	WsBinaryTaskContext *context = new WsBinaryTaskContext(this, std::move(message), seq);
+	Queue(context, GetDataLane());
+}
+
+YYJsonDocPtr WebSocketClient::ParseMessage(const std::string& message, std::string& error)
 {
-	if (!pMessageForward || !pMessageForward->GetFunctionCount())
+	yyjson_read_err readError;
+	YYJsonDocPtr document(yyjson_read_opts(const_cast<char*>(message.c_str()), message.length(), 0, nullptr, &readError));
+
+	if (readError.code)
+	{
+		char buffer[256];
+		snprintf(buffer, sizeof(buffer), "parse JSON message error (%u): %s at position: %zu", readError.code, readError.msg, readError.pos);
+		error = buffer;
+		return nullptr;
+	}
+
+	return document;
+}
+
+void WebSocketClient::ReportParseError(const std::string& error)
+{
+	smutils->LogError(myself, "%s", error.c_str());
+
+	if (!pErrorForward || !pErrorForward->GetFunctionCount())
 	{
 		return;
 	}
 
-	WsMessageTaskContext *context = new WsMessageTaskContext(this, message);
-	g_WebsocketExt.AddTaskToQueue(context);
+	pErrorForward->PushCell(m_websocket_handle);
+	pErrorForward->PushString(error.c_str());
+	pErrorForward->Execute(nullptr);
 }
 
 void WebSocketClient::OnOpen(ix::WebSocketOpenInfo openInfo) 
 {
+	// replay what was written while disconnected before anything new goes out
+	m_sendBuffer.Flush(m_webSocket, [this](const std::string &message, bool binary) {
+		return m_rateLimiter.Submit(message.data(), message.length(), binary, std::string()) || SendNow(message.data(), message.length(), binary);
+	});
+
 	if (!pOpenForward || !pOpenForward->GetFunctionCount())
 	{
 		return;
 	}
 
 	WsOpenTaskContext *context = new WsOpenTaskContext(this, openInfo);
-	g_WebsocketExt.AddTaskToQueue(context);
+	Queue(context, TaskLane_Control);
 }
 
 void WebSocketClient::OnClose(ix::WebSocketCloseInfo closeInfo) 
@@ -82,7 +252,7 @@ void WebSocketClient::OnClose(ix::WebSocketCloseInfo closeInfo)
 	}
 	
 	WsCloseTaskContext *context = new WsCloseTaskContext(this, closeInfo);
-	g_WebsocketExt.AddTaskToQueue(context);
+	Queue(context, TaskLane_Control);
 }
 
 void WebSocketClient::OnError(ix::WebSocketErrorInfo errorInfo) 
@@ -93,12 +263,15 @@ void WebSocketClient::OnError(ix::WebSocketErrorInfo errorInfo)
 	}
 
 	WsErrorTaskContext *context = new WsErrorTaskContext(this, errorInfo);
-	g_WebsocketExt.AddTaskToQueue(context);
+	Queue(context, TaskLane_Control);
 }
 
 void WsMessageTaskContext::OnCompleted()
 {
-	const size_t messageLength = m_message.length() + 1;
+	if (!m_client->Consume(m_seq))
+	{
+		return;
+	}
 
 	switch (m_client->m_callback_type)
 	{
@@ -106,24 +279,21 @@ void WsMessageTaskContext::OnCompleted()
 		{
 			m_client->pMessageForward->PushCell(m_client->m_websocket_handle);
 			m_client->pMessageForward->PushString(m_message.c_str());
-			m_client->pMessageForward->PushCell(messageLength);
+			m_client->pMessageForward->PushCell(m_messageLength);
 			m_client->pMessageForward->Execute(nullptr);
 			break;
 		}
 		case WebSocket_JSON:
 		{
-			auto pYYJsonWrapper = CreateWrapper();
-
-			yyjson_read_err readError;
-			yyjson_doc *idoc = yyjson_read_opts(const_cast<char*>(m_message.c_str()), messageLength, 0, nullptr, &readError);
-
-			if (readError.code)
+			if (!m_document)
 			{
-				yyjson_doc_free(idoc);
-				smutils->LogError(myself, "parse JSON message error (%u): %s at position: %d", readError.code, readError.msg, readError.pos);
+				m_client->ReportParseError(m_parseError);
 				return;
 			}
 
+			auto pYYJsonWrapper = CreateWrapper();
+
+			yyjson_doc *idoc = m_document.release();
 			pYYJsonWrapper->m_pDocument = WrapImmutableDocument(idoc);
 			pYYJsonWrapper->m_pVal = yyjson_doc_get_root(idoc);
 
@@ -139,7 +309,7 @@ void WsMessageTaskContext::OnCompleted()
 
 			m_client->pMessageForward->PushCell(m_client->m_websocket_handle);
 			m_client->pMessageForward->PushCell(m_client->m_json_handle);
-			m_client->pMessageForward->PushCell(messageLength);
+			m_client->pMessageForward->PushCell(m_messageLength);
 			m_client->pMessageForward->Execute(nullptr);
 
 			handlesys->FreeHandle(m_client->m_json_handle, &pSec);
@@ -148,6 +318,86 @@ void WsMessageTaskContext::OnCompleted()
 	}
 }
 
+void WsBinaryTaskContext::OnCompleted()
+{
+	if (!m_client->Consume(m_seq) || !m_client->pBinaryForward)
+	{
+		return;
+	}
+
+	m_client->pBinaryForward->PushCell(m_client->m_websocket_handle);
+	m_client->pBinaryForward->PushStringEx(m_message.data(), m_message.length(), SM_PARAM_STRING_BINARY | SM_PARAM_STRING_COPY, 0);
+	m_client->pBinaryForward->PushCell(m_message.length());
+	m_client->pBinaryForward->Execute(nullptr);
+}
+
+void WsBatchTaskContext::OnCompleted()
+{
+	std::vector<BatchedMessage> messages;
+	m_client->m_batch.Take(messages);
+
+	yyjson_mut_doc *doc = yyjson_mut_doc_new(nullptr);
+	yyjson_mut_val *root = yyjson_mut_arr(doc);
+	yyjson_mut_doc_set_root(doc, root);
+
+	for (const auto& entry : messages)
+	{
+		if (!m_client->Consume(entry.seq))
+		{
+			continue;
+		}
+
+		switch (m_client->m_callback_type)
+		{
+			case Websocket_STRING:
+			{
+				yyjson_mut_arr_add_val(root, yyjson_mut_strncpy(doc, entry.message.c_str(), entry.message.length()));
+				break;
+			}
+			case WebSocket_JSON:
+			{
+				if (!entry.document)
+				{
+					m_client->ReportParseError(entry.parseError);
+					continue;
+				}
+
+				yyjson_mut_arr_add_val(root, yyjson_val_mut_copy(doc, yyjson_doc_get_root(entry.document.get())));
+				break;
+			}
+		}
+	}
+
+	size_t count = yyjson_mut_arr_size(root);
+
+	if (!count || !m_client->pBatchForward)
+	{
+		yyjson_mut_doc_free(doc);
+		return;
+	}
+
+	auto pYYJsonWrapper = CreateWrapper();
+	pYYJsonWrapper->m_pDocument_mut = WrapDocument(doc);
+	pYYJsonWrapper->m_pVal_mut = root;
+
+	HandleError err;
+	HandleSecurity pSec(nullptr, myself->GetIdentity());
+	Handle_t batchHandle = handlesys->CreateHandleEx(g_htJSON, pYYJsonWrapper.release(), &pSec, nullptr, &err);
+
+	if (!batchHandle)
+	{
+		smutils->LogError(myself, "Could not create JSON handle (error %d)", err);
+		return;
+	}
+
+	m_client->pBatchForward->PushCell(m_client->m_websocket_handle);
+	m_client->pBatchForward->PushCell(batchHandle);
+	m_client->pBatchForward->PushCell(count);
+	m_client->pBatchForward->Execute(nullptr);
+
+	handlesys->FreeHandle(batchHandle, &pSec);
+}
+
 void WsOpenTaskContext::OnCompleted()
 {
 	m_client->pOpenForward->PushCell(m_client->m_websocket_handle);
@@ -6,22 +6,51 @@ enum
 	Websocket_STRING,
 };
 
-class WebSocketClient
+class WebSocketClient : public TaskSource
 {
 public:
 	WebSocketClient(const char *url, uint8_t callbacktype);
-	WebSocketClient(ix::WebSocket* existingSocket);
+	WebSocketClient(std::shared_ptr<ix::WebSocket> serverSocket);
 	~WebSocketClient();
 
 	bool IsConnected();
 
+	/**
+	 * @brief Sends a message, or holds it in the send buffer or rate limiter.
+	 *
+	 * @param key Messages with the same non-empty key replace each other while rate limited.
+	 */
+	bool Send(const char *data, size_t length, bool binary = false, const std::string &key = std::string());
+
+	/**
+	 * @brief Sends a message right away, without copying it.
+	 */
+	bool SendNow(const char *data, size_t length, bool binary);
+
+	virtual Handle_t GetSourceHandle() override { return m_websocket_handle; }
+
 public:
-	void OnMessage(const std::string &message);
+	void OnMessage(std::string &&message);
+	void OnBinaryMessage(std::string &&message);
 	void OnOpen(ix::WebSocketOpenInfo openInfo);
 	void OnClose(ix::WebSocketCloseInfo closeInfo);
 	void OnError(ix::WebSocketErrorInfo errorInfo);
+
+	/**
+	 * @brief Parses a message on the network thread.
+	 *
+	 * @return The document, or nullptr with error set to a description of the failure.
+	 */
+	static YYJsonDocPtr ParseMessage(const std::string &message, std::string &error);
+
+	/**
+	 * @brief Logs a message parse failure and passes it to the error forward.
+	 */
+	void ReportParseError(const std::string &error);
 	
 	ix::WebSocket* m_webSocket;
+	// keeps a server connection alive while plugins hold its handle
+	std::shared_ptr<ix::WebSocket> m_serverSocket;
 	Handle_t m_websocket_handle = BAD_HANDLE;
 	Handle_t m_json_handle = BAD_HANDLE;
 	
@@ -30,30 +59,76 @@ public:
 	ix::WebSocketHttpHeaders m_extraHeaders;
 	bool m_keepConnecting = false;
 
+	MessageBatch m_batch;
+	MessageFilter m_filter;
+	Heartbeat m_heartbeat{this};
+	AsyncJsonWriter m_jsonWriter;
+	SendBuffer m_sendBuffer;
+	RateLimiter m_rateLimiter{this};
+	ConnectionStats m_stats;
+
 	IChangeableForward *pMessageForward = nullptr;
+	IChangeableForward *pBatchForward = nullptr;
+	IChangeableForward *pBinaryForward = nullptr;
+	IChangeableForward *pHeartbeatForward = nullptr;
 	IChangeableForward *pOpenForward = nullptr;
 	IChangeableForward *pCloseForward = nullptr;
 	IChangeableForward *pErrorForward = nullptr;
 };
 
-class WsMessageTaskContext : public ITaskContext
+class WsMessageTaskContext : public SourceTaskContext<WsMessageTaskContext>
 {
 public:
-	WsMessageTaskContext(WebSocketClient* client, const std::string& message) 
-		: m_client(client), m_message(message) {}
+	WsMessageTaskContext(WebSocketClient* client, std::string&& message, uint64_t seq) 
+		: SourceTaskContext(client), m_client(client), m_message(std::move(message)), m_seq(seq), m_messageLength(m_message.length() + 1) {}
+
+	WsMessageTaskContext(WebSocketClient* client, YYJsonDocPtr document, const std::string& parseError, size_t length, uint64_t seq) 
+		: SourceTaskContext(client), m_client(client), m_seq(seq), m_messageLength(length + 1), m_document(std::move(document)), m_parseError(parseError) {}
 	
 	virtual void OnCompleted() override;
 	
 private:
 	WebSocketClient* m_client;
 	std::string m_message;
+	uint64_t m_seq;
+	size_t m_messageLength;
+
+	// WebSocket_JSON clients receive the parsed document instead of the message
+	YYJsonDocPtr m_document;
+	std::string m_parseError;
+};
+
+class WsBinaryTaskContext : public SourceTaskContext<WsBinaryTaskContext>
+{
+public:
+	WsBinaryTaskContext(WebSocketClient* client, std::string&& message, uint64_t seq) 
+		: SourceTaskContext(client), m_client(client), m_message(std::move(message)), m_seq(seq) {}
+	
+	virtual void OnCompleted() override;
+	
+private:
+	WebSocketClient* m_client;
+	std::string m_message;
+	uint64_t m_seq;
+};
+
+class WsBatchTaskContext : public SourceTaskContext<WsBatchTaskContext>
+{
+public:
+	WsBatchTaskContext(WebSocketClient* client) 
+		: SourceTaskContext(client), m_client(client) {}
+	
+	virtual void OnCompleted() override;
+	
+private:
+	WebSocketClient* m_client;
 };
 
-class WsOpenTaskContext : public ITaskContext
+class WsOpenTaskContext : public SourceTaskContext<WsOpenTaskContext>
 {
 public:
 	WsOpenTaskContext(WebSocketClient* client, ix::WebSocketOpenInfo openInfo) 
-		: m_client(client), m_openInfo(openInfo) {}
+		: SourceTaskContext(client), m_client(client), m_openInfo(openInfo) {}
 	
 	virtual void OnCompleted() override;
 	
@@ -62,11 +137,11 @@ private:
 	ix::WebSocketOpenInfo m_openInfo;
 };
 
-class WsCloseTaskContext : public ITaskContext
+class WsCloseTaskContext : public SourceTaskContext<WsCloseTaskContext>
 {
 public:
 	WsCloseTaskContext(WebSocketClient* client, ix::WebSocketCloseInfo closeInfo) 
-		: m_client(client), m_closeInfo(closeInfo) {}
+		: SourceTaskContext(client), m_client(client), m_closeInfo(closeInfo) {}
 	
 	virtual void OnCompleted() override;
 	
@@ -75,11 +150,11 @@ private:
 	ix::WebSocketCloseInfo m_closeInfo;
 };
 
-class WsErrorTaskContext : public ITaskContext
+class WsErrorTaskContext : public SourceTaskContext<WsErrorTaskContext>
 {
 public:
 	WsErrorTaskContext(WebSocketClient* client, ix::WebSocketErrorInfo errorInfo) 
-		: m_client(client), m_errorInfo(errorInfo) {}
+		: SourceTaskContext(client), m_client(client), m_errorInfo(errorInfo) {}
 	
 	virtual void OnCompleted() override;
 	
@@ -135,6 +135,369 @@ static cell_t ws_SetErrorCallback(IPluginContext *pContext, const cell_t *params
 	return 1;
 }
 
+static cell_t ws_SetBatchMessageCallback(IPluginContext *pContext, const cell_t *params)
+{
+	WebSocketClient *pWebSocketClient = GetWsPointer(pContext, params[1]);
+
+	if (!pWebSocketClient)
+	{
+		return 0;
+	}
+
+	IPluginFunction *callback = pContext->GetFunctionById(params[2]);
+
+	if (pWebSocketClient->pBatchForward) {
+		forwards->ReleaseForward(pWebSocketClient->pBatchForward);
+	}
+
+	pWebSocketClient->pBatchForward = forwards->CreateForwardEx(nullptr, ET_Ignore, 3, nullptr, Param_Cell, Param_Cell, Param_Cell);
+	if (!pWebSocketClient->pBatchForward || !pWebSocketClient->pBatchForward->AddFunction(callback))
+	{
+		pContext->ReportError("Could not create batch message forward.");
+		return 0;
+	}
+
+	return 1;
+}
+
+static cell_t ws_SetBinaryMessageCallback(IPluginContext *pContext, const cell_t *params)
+{
+	WebSocketClient *pWebSocketClient = GetWsPointer(pContext, params[1]);
+
+	if (!pWebSocketClient)
+	{
+		return 0;
+	}
+
+	IPluginFunction *callback = pContext->GetFunctionById(params[2]);
+
+	if (pWebSocketClient->pBinaryForward) {
+		forwards->ReleaseForward(pWebSocketClient->pBinaryForward);
+	}
+
+	pWebSocketClient->pBinaryForward = forwards->CreateForwardEx(nullptr, ET_Ignore, 3, nullptr, Param_Cell, Param_String, Param_Cell);
+	if (!pWebSocketClient->pBinaryForward || !pWebSocketClient->pBinaryForward->AddFunction(callback))
+	{
+		pContext->ReportError("Could not create binary message forward.");
+		return 0;
+	}
+
+	return 1;
+}
+
+static cell_t ws_SetHeartbeatCallback(IPluginContext *pContext, const cell_t *params)
+{
+	WebSocketClient *pWebSocketClient = GetWsPointer(pContext, params[1]);
+
+	if (!pWebSocketClient)
+	{
+		return 0;
+	}
+
+	IPluginFunction *callback = pContext->GetFunctionById(params[2]);
+
+	if (pWebSocketClient->pHeartbeatForward) {
+		forwards->ReleaseForward(pWebSocketClient->pHeartbeatForward);
+	}
+
+	pWebSocketClient->pHeartbeatForward = forwards->CreateForwardEx(nullptr, ET_Ignore, 2, nullptr, Param_Cell, Param_Cell);
+	if (!pWebSocketClient->pHeartbeatForward || !pWebSocketClient->pHeartbeatForward->AddFunction(callback))
+	{
+		pContext->ReportError("Could not create heartbeat forward.");
+		return 0;
+	}
+
+	return 1;
+}
+
+static cell_t ws_SetDropCallback(IPluginContext *pContext, const cell_t *params)
+{
+	WebSocketClient *pWebSocketClient = GetWsPointer(pContext, params[1]);
+
+	if (!pWebSocketClient)
+	{
+		return 0;
+	}
+
+	IPluginFunction *callback = pContext->GetFunctionById(params[2]);
+
+	if (pWebSocketClient->pDropForward) {
+		forwards->ReleaseForward(pWebSocketClient->pDropForward);
+	}
+
+	pWebSocketClient->pDropForward = forwards->CreateForwardEx(nullptr, ET_Ignore, 2, nullptr, Param_Cell, Param_Cell);
+	if (!pWebSocketClient->pDropForward || !pWebSocketClient->pDropForward->AddFunction(callback))
+	{
+		pContext->ReportError("Could not create drop forward.");
+		return 0;
+	}
+
+	return 1;
+}
+
+static cell_t ws_SetQueueLimit(IPluginContext *pContext, const cell_t *params)
+{
+	WebSocketClient *pWebSocketClient = GetWsPointer(pContext, params[1]);
+
+	if (!pWebSocketClient)
+	{
+		return 0;
+	}
+
+	if (params[2] < 0 || params[3] < QueuePolicy_DropOldest || params[3] > QueuePolicy_Pause)
+	{
+		pContext->ReportError("Invalid queue limit %d or policy %d", params[2], params[3]);
+		return 0;
+	}
+
+	pWebSocketClient->SetQueueLimit(params[2], static_cast<QueuePolicy>(params[3]));
+
+	return 1;
+}
+
+static cell_t ws_SetSendBuffer(IPluginContext *pContext, const cell_t *params)
+{
+	WebSocketClient *pWebSocketClient = GetWsPointer(pContext, params[1]);
+
+	if (!pWebSocketClient)
+	{
+		return 0;
+	}
+
+	if (params[2] < 0 || params[3] < 0)
+	{
+		pContext->ReportError("Invalid send buffer limit of %d messages and %d bytes", params[2], params[3]);
+		return 0;
+	}
+
+	if (params[4] != QueuePolicy_DropOldest && params[4] != QueuePolicy_DropNewest)
+	{
+		pContext->ReportError("Invalid send buffer policy %d", params[4]);
+		return 0;
+	}
+
+	pWebSocketClient->m_sendBuffer.SetLimit(params[2], params[3], static_cast<QueuePolicy>(params[4]));
+
+	return 1;
+}
+
+static cell_t ws_GetSendBufferStats(IPluginContext *pContext, const cell_t *params)
+{
+	WebSocketClient *pWebSocketClient = GetWsPointer(pContext, params[1]);
+
+	if (!pWebSocketClient)
+	{
+		return 0;
+	}
+
+	cell_t *queuedAddr, *flushedAddr, *droppedAddr;
+	pContext->LocalToPhysAddr(params[2], &queuedAddr);
+	pContext->LocalToPhysAddr(params[3], &flushedAddr);
+	pContext->LocalToPhysAddr(params[4], &droppedAddr);
+
+	*queuedAddr = static_cast<cell_t>(pWebSocketClient->m_sendBuffer.GetQueued());
+	*flushedAddr = static_cast<cell_t>(pWebSocketClient->m_sendBuffer.GetFlushed());
+	*droppedAddr = static_cast<cell_t>(pWebSocketClient->m_sendBuffer.GetDropped());
+
+	return 1;
+}
+
+static cell_t ws_GetPendingSends(IPluginContext *pContext, const cell_t *params)
+{
+	WebSocketClient *pWebSocketClient = GetWsPointer(pContext, params[1]);
+
+	if (!pWebSocketClient)
+	{
+		return 0;
+	}
+
+	return static_cast<cell_t>(pWebSocketClient->m_sendBuffer.GetPending());
+}
+
+static cell_t ws_ConfigureDeflate(IPluginContext *pContext, const cell_t *params)
+{
+	WebSocketClient *pWebSocketClient = GetWsPointer(pContext, params[1]);
+
+	if (!pWebSocketClient)
+	{
+		return 0;
+	}
+
+	int level = params[2], minSize = params[3], windowBits = params[4], peerWindowBits = params[6];
+
+	if (level < -1 || level > 9 || minSize < 0 || windowBits < 8 || windowBits > 15 || peerWindowBits < 8 || peerWindowBits > 15)
+	{
+		pContext->ReportError("Invalid deflate options: level %d, min size %d, window bits %d, peer window bits %d", level, minSize, windowBits, peerWindowBits);
+		return 0;
+	}
+
+	// we compress with the client window, the server with its own
+	ix::WebSocketPerMessageDeflateOptions options(true, params[5] != 0, params[7] != 0, windowBits, peerWindowBits);
+	options.setCompressionLevel(level);
+	options.setMinCompressSize(minSize);
+
+	pWebSocketClient->m_webSocket->setPerMessageDeflateOptions(options);
+
+	return 1;
+}
+
+static cell_t ws_DisableDeflate(IPluginContext *pContext, const cell_t *params)
+{
+	WebSocketClient *pWebSocketClient = GetWsPointer(pContext, params[1]);
+
+	if (!pWebSocketClient)
+	{
+		return 0;
+	}
+
+	pWebSocketClient->m_webSocket->disablePerMessageDeflate();
+
+	return 1;
+}
+
+static cell_t ws_SetRateLimit(IPluginContext *pContext, const cell_t *params)
+{
+	WebSocketClient *pWebSocketClient = GetWsPointer(pContext, params[1]);
+
+	if (!pWebSocketClient)
+	{
+		return 0;
+	}
+
+	if (params[2] < 0 || params[3] < 1 || params[4] < 0)
+	{
+		pContext->ReportError("Invalid rate limit of %d messages per %d ms with %d queued", params[2], params[3], params[4]);
+		return 0;
+	}
+
+	pWebSocketClient->m_rateLimiter.SetLimit(params[2], params[3], params[4]);
+
+	return 1;
+}
+
+static cell_t ws_GetRateLimitStats(IPluginContext *pContext, const cell_t *params)
+{
+	WebSocketClient *pWebSocketClient = GetWsPointer(pContext, params[1]);
+
+	if (!pWebSocketClient)
+	{
+		return 0;
+	}
+
+	cell_t *queuedAddr, *coalescedAddr, *droppedAddr;
+	pContext->LocalToPhysAddr(params[2], &queuedAddr);
+	pContext->LocalToPhysAddr(params[3], &coalescedAddr);
+	pContext->LocalToPhysAddr(params[4], &droppedAddr);
+
+	*queuedAddr = static_cast<cell_t>(pWebSocketClient->m_rateLimiter.GetQueued());
+	*coalescedAddr = static_cast<cell_t>(pWebSocketClient->m_rateLimiter.GetCoalesced());
+	*droppedAddr = static_cast<cell_t>(pWebSocketClient->m_rateLimiter.GetDropped());
+
+	return 1;
+}
+
+static cell_t ws_GetRateLimitedSends(IPluginContext *pContext, const cell_t *params)
+{
+	WebSocketClient *pWebSocketClient = GetWsPointer(pContext, params[1]);
+
+	if (!pWebSocketClient)
+	{
+		return 0;
+	}
+
+	return static_cast<cell_t>(pWebSocketClient->m_rateLimiter.GetPending());
+}
+
+static cell_t ws_AddFilter(IPluginContext *pContext, const cell_t *params)
+{
+	WebSocketClient *pWebSocketClient = GetWsPointer(pContext, params[1]);
+
+	if (!pWebSocketClient)
+	{
+		return 0;
+	}
+
+	if (params[4] < FilterMatch_Equals || params[4] > FilterMatch_Prefix)
+	{
+		pContext->ReportError("Invalid filter match %d", params[4]);
+		return 0;
+	}
+
+	char *pointer, *value;
+	pContext->LocalToString(params[2], &pointer);
+	pContext->LocalToString(params[3], &value);
+
+	std::string error;
+	if (!pWebSocketClient->m_filter.AddRule(pointer, value, static_cast<FilterMatch>(params[4]), error))
+	{
+		pContext->ReportError("Invalid filter \"%s\": %s", pointer, error.c_str());
+		return 0;
+	}
+
+	return 1;
+}
+
+static cell_t ws_ClearFilters(IPluginContext *pContext, const cell_t *params)
+{
+	WebSocketClient *pWebSocketClient = GetWsPointer(pContext, params[1]);
+
+	if (!pWebSocketClient)
+	{
+		return 0;
+	}
+
+	pWebSocketClient->m_filter.Clear();
+
+	return 1;
+}
+
+static cell_t ws_Filtering(IPluginContext *pContext, const cell_t *params)
+{
+	WebSocketClient *pWebSocketClient = GetWsPointer(pContext, params[1]);
+
+	if (!pWebSocketClient)
+	{
+		return 0;
+	}
+
+	if (params[0] == 2) {
+		if (params[2] < FilterMode_Allow || params[2] > FilterMode_Deny)
+		{
+			pContext->ReportError("Invalid filter mode %d", params[2]);
+			return 0;
+		}
+
+		pWebSocketClient->m_filter.SetMode(static_cast<FilterMode>(params[2]));
+		return 1;
+	}
+
+	return pWebSocketClient->m_filter.GetMode();
+}
+
+static cell_t ws_GetFilteredMessages(IPluginContext *pContext, const cell_t *params)
+{
+	WebSocketClient *pWebSocketClient = GetWsPointer(pContext, params[1]);
+
+	if (!pWebSocketClient)
+	{
+		return 0;
+	}
+
+	return static_cast<cell_t>(pWebSocketClient->m_filter.GetFiltered());
+}
+
+static cell_t ws_GetQueuedMessages(IPluginContext *pContext, const cell_t *params)
+{
+	WebSocketClient *pWebSocketClient = GetWsPointer(pContext, params[1]);
+
+	if (!pWebSocketClient)
+	{
+		return 0;
+	}
+
+	return static_cast<cell_t>(pWebSocketClient->GetQueued());
+}
+
 static cell_t ws_Connect(IPluginContext *pContext, const cell_t *params)
 {
 	WebSocketClient* pWebSocketClient = GetWsPointer(pContext, params[1]);
@@ -150,6 +513,13 @@ static cell_t ws_Connect(IPluginContext *pContext, const cell_t *params)
 		return 0;
 	}
 
+	if (pWebSocketClient->m_serverSocket)
+	{
+		pContext->ReportError("WebSocket was accepted by a server and can not connect");
+		return 0;
+	}
+
+	pWebSocketClient->Resume();
 	pWebSocketClient->m_webSocket->start();
 
 	return 1;
@@ -164,6 +534,7 @@ static cell_t ws_Disconnect(IPluginContext *pContext, const cell_t *params)
 		return 0;
 	}
 
+	pWebSocketClient->Interrupt();
 	pWebSocketClient->m_webSocket->stop();
 
 	return 1;
@@ -234,6 +605,20 @@ static cell_t ws_GetReadyState(IPluginContext *pContext, const cell_t *params)
 	return (cell_t)pWebSocketClient->m_webSocket->getReadyState();
 }
 
+// optional coalescing key of the write natives
+static std::string GetSendKey(IPluginContext *pContext, const cell_t *params, int param)
+{
+	if (params[0] < param)
+	{
+		return std::string();
+	}
+
+	char *key;
+	pContext->LocalToString(params[param], &key);
+
+	return key;
+}
+
 static cell_t ws_WriteString(IPluginContext *pContext, const cell_t *params)
 {
 	WebSocketClient* pWebSocketClient = GetWsPointer(pContext, params[1]);
@@ -246,7 +631,29 @@ static cell_t ws_WriteString(IPluginContext *pContext, const cell_t *params)
 	char *msg;
 	pContext->LocalToString(params[2], &msg);
 
-	pWebSocketClient->m_webSocket->send(msg);
+	pWebSocketClient->Send(msg, strlen(msg), false, GetSendKey(pContext, params, 3));
+
+	return 1;
+}
+
+static cell_t ws_WriteBinary(IPluginContext *pContext, const cell_t *params)
+{
+	WebSocketClient* pWebSocketClient = GetWsPointer(pContext, params[1]);
+
+	if (!pWebSocketClient)
+	{
+		return 0;
+	}
+
+	// the frame is built straight from plugin memory unless it has to wait
+	char *data = g_WebsocketExt.GetBinaryPointer(pContext, params[2], params[3]);
+
+	if (!data)
+	{
+		return 0;
+	}
+
+	pWebSocketClient->Send(data, params[3], true, GetSendKey(pContext, params, 4));
 
 	return 1;
 }
@@ -267,6 +674,29 @@ static cell_t ws_WriteJSON(IPluginContext *pContext, const cell_t *params)
 		return 0;
 	}
 
+	std::string key = GetSendKey(pContext, params, 4);
+
+	if (params[0] >= 3 && params[3])
+	{
+		YYJsonDocPtr snapshot = pYYJsonWrapper->IsMutable()
+			? AsyncJsonWriter::Snapshot(pYYJsonWrapper->m_pVal_mut)
+			: AsyncJsonWriter::Snapshot(pYYJsonWrapper->m_pVal);
+
+		if (!snapshot)
+		{
+			return 0;
+		}
+
+		pWebSocketClient->m_jsonWriter.Submit(std::move(snapshot), [pWebSocketClient, key](std::string &&text) {
+			if (!text.empty())
+			{
+				pWebSocketClient->Send(text.data(), text.length(), false, key);
+			}
+		});
+
+		return 1;
+	}
+
 	char *json_str = yyjson_mut_val_write(pYYJsonWrapper->m_pVal_mut, 0, nullptr);
 	
 	if (!json_str)
@@ -274,7 +704,7 @@ static cell_t ws_WriteJSON(IPluginContext *pContext, const cell_t *params)
 		return 0;
 	}
 
-	pWebSocketClient->m_webSocket->send(json_str);
+	pWebSocketClient->Send(json_str, strlen(json_str), false, key);
 	free(json_str);
 
 	return 1;
@@ -373,6 +803,140 @@ static cell_t ws_PingInterval(IPluginContext *pContext, const cell_t *params)
 	return pWebSocketClient->m_webSocket->getPingInterval();
 }
 
+static cell_t ws_HighPriority(IPluginContext *pContext, const cell_t *params)
+{
+	WebSocketClient *pWebSocketClient = GetWsPointer(pContext, params[1]);
+
+	if (!pWebSocketClient)
+	{
+		return 0;
+	}
+
+	if (params[0] == 2) {
+		pWebSocketClient->SetHighPriority(params[2]);
+		return 1;
+	}
+
+	return pWebSocketClient->IsHighPriority();
+}
+
+static cell_t ws_StartHeartbeat(IPluginContext *pContext, const cell_t *params)
+{
+	WebSocketClient *pWebSocketClient = GetWsPointer(pContext, params[1]);
+
+	if (!pWebSocketClient)
+	{
+		return 0;
+	}
+
+	if (params[2] <= 0)
+	{
+		pContext->ReportError("Invalid heartbeat interval %d", params[2]);
+		return 0;
+	}
+
+	char *payload, *seqPointer, *ackPointer, *ackValue;
+	pContext->LocalToString(params[3], &payload);
+	pContext->LocalToString(params[4], &seqPointer);
+	pContext->LocalToString(params[5], &ackPointer);
+	pContext->LocalToString(params[6], &ackValue);
+
+	std::string error;
+	if (!pWebSocketClient->m_heartbeat.Start(params[2], payload, seqPointer, ackPointer, ackValue, error))
+	{
+		pContext->ReportError("Invalid heartbeat: %s", error.c_str());
+		return 0;
+	}
+
+	return 1;
+}
+
+static cell_t ws_StopHeartbeat(IPluginContext *pContext, const cell_t *params)
+{
+	WebSocketClient *pWebSocketClient = GetWsPointer(pContext, params[1]);
+
+	if (!pWebSocketClient)
+	{
+		return 0;
+	}
+
+	pWebSocketClient->m_heartbeat.Stop();
+
+	return 1;
+}
+
+static cell_t ws_GetHeartbeatRTT(IPluginContext *pContext, const cell_t *params)
+{
+	WebSocketClient *pWebSocketClient = GetWsPointer(pContext, params[1]);
+
+	if (!pWebSocketClient)
+	{
+		return 0;
+	}
+
+	return pWebSocketClient->m_heartbeat.GetRTT();
+}
+
+static cell_t ws_GetStats(IPluginContext *pContext, const cell_t *params)
+{
+	WebSocketClient *pWebSocketClient = GetWsPointer(pContext, params[1]);
+
+	if (!pWebSocketClient)
+	{
+		return 0;
+	}
+
+	const ConnectionStats &stats = pWebSocketClient->m_stats;
+
+	auto pYYJsonWrapper = CreateWrapper();
+	pYYJsonWrapper->m_pDocument_mut = CreateDocument();
+
+	yyjson_mut_doc *doc = pYYJsonWrapper->m_pDocument_mut.get();
+	yyjson_mut_val *root = yyjson_mut_obj(doc);
+	yyjson_mut_doc_set_root(doc, root);
+
+	yyjson_mut_obj_add_bool(doc, root, "connected", pWebSocketClient->IsConnected());
+	yyjson_mut_obj_add_int(doc, root, "rtt", pWebSocketClient->m_webSocket->getPingRtt());
+	yyjson_mut_obj_add_int(doc, root, "heartbeatRtt", pWebSocketClient->m_heartbeat.GetRTT());
+	yyjson_mut_obj_add_uint(doc, root, "messagesIn", stats.GetMessagesIn());
+	yyjson_mut_obj_add_uint(doc, root, "bytesIn", stats.GetBytesIn());
+	yyjson_mut_obj_add_uint(doc, root, "messagesOut", stats.GetMessagesOut());
+	yyjson_mut_obj_add_uint(doc, root, "bytesOut", stats.GetBytesOut());
+	yyjson_mut_obj_add_uint(doc, root, "bufferedAmount", pWebSocketClient->m_webSocket->bufferedAmount());
+	yyjson_mut_obj_add_uint(doc, root, "pendingSends", pWebSocketClient->m_sendBuffer.GetPending() + pWebSocketClient->m_rateLimiter.GetPending());
+	yyjson_mut_obj_add_uint(doc, root, "reconnects", stats.GetReconnects());
+
+	pYYJsonWrapper->m_pVal_mut = root;
+
+	HandleError err;
+	HandleSecurity sec(pContext->GetIdentity(), myself->GetIdentity());
+	pYYJsonWrapper->m_handle = handlesys->CreateHandleEx(g_htJSON, pYYJsonWrapper.get(), &sec, nullptr, &err);
+
+	if (!pYYJsonWrapper->m_handle)
+	{
+		return pContext->ThrowNativeError("Failed to create handle (error code: %d)", err);
+	}
+
+	return pYYJsonWrapper.release()->m_handle;
+}
+
+static cell_t ws_SharedLoop(IPluginContext *pContext, const cell_t *params)
+{
+	WebSocketClient *pWebSocketClient = GetWsPointer(pContext, params[1]);
+
+	if (!pWebSocketClient)
+	{
+		return 0;
+	}
+
+	if (params[0] == 2) {
+		pWebSocketClient->m_webSocket->setReactor(params[2] && ix::WebSocketReactor::isSupported() ? &g_WebSocketReactor : nullptr);
+		return 1;
+	}
+
+	return pWebSocketClient->m_webSocket->getReactor() != nullptr;
+}
+
 const sp_nativeinfo_t ws_natives[] =
 {
 	// client
@@ -381,10 +945,38 @@ const sp_nativeinfo_t ws_natives[] =
 	{"WebSocket.SetOpenCallback",        ws_SetOpenCallback},
 	{"WebSocket.SetCloseCallback",       ws_SetCloseCallback},
 	{"WebSocket.SetErrorCallback",       ws_SetErrorCallback},
+	{"WebSocket.SetBatchMessageCallback", ws_SetBatchMessageCallback},
+	{"WebSocket.SetBinaryMessageCallback", ws_SetBinaryMessageCallback},
+	{"WebSocket.SetDropCallback",        ws_SetDropCallback},
+	{"WebSocket.SetHeartbeatCallback",   ws_SetHeartbeatCallback},
+	{"WebSocket.SetQueueLimit",          ws_SetQueueLimit},
+	{"WebSocket.QueuedMessages.get",     ws_GetQueuedMessages},
+	{"WebSocket.SetSendBuffer",          ws_SetSendBuffer},
+	{"WebSocket.GetSendBufferStats",     ws_GetSendBufferStats},
+	{"WebSocket.PendingSends.get",       ws_GetPendingSends},
+	{"WebSocket.SetRateLimit",           ws_SetRateLimit},
+	{"WebSocket.ConfigureDeflate",       ws_ConfigureDeflate},
+	{"WebSocket.DisableDeflate",         ws_DisableDeflate},
+	{"WebSocket.GetRateLimitStats",      ws_GetRateLimitStats},
+	{"WebSocket.RateLimitedSends.get",   ws_GetRateLimitedSends},
+	{"WebSocket.AddFilter",              ws_AddFilter},
+	{"WebSocket.ClearFilters",           ws_ClearFilters},
+	{"WebSocket.Filtering.get",          ws_Filtering},
+	{"WebSocket.Filtering.set",          ws_Filtering},
+	{"WebSocket.FilteredMessages.get",   ws_GetFilteredMessages},
+	{"WebSocket.HighPriority.get",       ws_HighPriority},
+	{"WebSocket.HighPriority.set",       ws_HighPriority},
+	{"WebSocket.StartHeartbeat",         ws_StartHeartbeat},
+	{"WebSocket.StopHeartbeat",          ws_StopHeartbeat},
+	{"WebSocket.HeartbeatRTT.get",       ws_GetHeartbeatRTT},
+	{"WebSocket.GetStats",               ws_GetStats},
+	{"WebSocket.SharedLoop.get",         ws_SharedLoop},
+	{"WebSocket.SharedLoop.set",         ws_SharedLoop},
 	{"WebSocket.Connect",                ws_Connect},
 	{"WebSocket.SetHeader",              ws_SetHeader},
 	{"WebSocket.GetHeader",              ws_GetHeader},
 	{"WebSocket.WriteString",            ws_WriteString},
+	{"WebSocket.WriteBinary",            ws_WriteBinary},
 	{"WebSocket.WriteJSON",              ws_WriteJSON},
 	{"WebSocket.Disconnect",             ws_Disconnect},
 	{"WebSocket.Connected.get",          ws_GetConnected},
@@ -50,7 +50,7 @@ static cell_t ws_SetMessageCallback(IPluginContext *pContext, const cell_t *para
 		forwards->ReleaseForward(pWebsocketServer->pMessageForward);
 	}
 	
-	pWebsocketServer->pMessageForward = forwards->CreateForwardEx(nullptr, ET_Ignore, 6, nullptr, Param_Cell, Param_Cell, Param_String, Param_Cell, Param_String, Param_String);
+	pWebsocketServer->pMessageForward = forwards->CreateForwardEx(nullptr, ET_Ignore, 7, nullptr, Param_Cell, Param_Cell, Param_String, Param_Cell, Param_String, Param_String, Param_Cell);
 	if (!pWebsocketServer->pMessageForward || !pWebsocketServer->pMessageForward->AddFunction(callback))
 	{
 		pContext->ReportError("Could not create message forward.");
@@ -75,7 +75,7 @@ static cell_t ws_SetOpenCallback(IPluginContext *pContext, const cell_t *params)
 		forwards->ReleaseForward(pWebsocketServer->pOpenForward);
 	}
 
-	pWebsocketServer->pOpenForward = forwards->CreateForwardEx(nullptr, ET_Ignore, 3, nullptr, Param_Cell, Param_String, Param_String);
+	pWebsocketServer->pOpenForward = forwards->CreateForwardEx(nullptr, ET_Ignore, 4, nullptr, Param_Cell, Param_String, Param_String, Param_Cell);
 	if (!pWebsocketServer->pOpenForward || !pWebsocketServer->pOpenForward->AddFunction(callback))
 	{
 		pContext->ReportError("Could not create open forward.");
@@ -100,7 +100,7 @@ static cell_t ws_SetCloseCallback(IPluginContext *pContext, const cell_t *params
 		forwards->ReleaseForward(pWebsocketServer->pCloseForward);
 	}
 
-	pWebsocketServer->pCloseForward = forwards->CreateForwardEx(nullptr, ET_Ignore, 5, nullptr, Param_Cell, Param_Cell, Param_String, Param_String, Param_String);
+	pWebsocketServer->pCloseForward = forwards->CreateForwardEx(nullptr, ET_Ignore, 6, nullptr, Param_Cell, Param_Cell, Param_String, Param_String, Param_String, Param_Cell);
 	if (!pWebsocketServer->pCloseForward || !pWebsocketServer->pCloseForward->AddFunction(callback))
 	{
 		pContext->ReportError("Could not create close forward.");
@@ -125,7 +125,7 @@ static cell_t ws_SetErrorCallback(IPluginContext *pContext, const cell_t *params
 		forwards->ReleaseForward(pWebsocketServer->pErrorForward);
 	}
 
-	pWebsocketServer->pErrorForward = forwards->CreateForwardEx(nullptr, ET_Ignore, 4, nullptr, Param_Cell, Param_String, Param_String, Param_String);
+	pWebsocketServer->pErrorForward = forwards->CreateForwardEx(nullptr, ET_Ignore, 5, nullptr, Param_Cell, Param_String, Param_String, Param_String, Param_Cell);
 	if (!pWebsocketServer->pErrorForward || !pWebsocketServer->pErrorForward->AddFunction(callback))
 	{
 		pContext->ReportError("Could not create error forward.");
@@ -135,6 +135,191 @@ static cell_t ws_SetErrorCallback(IPluginContext *pContext, const cell_t *params
 	return 1;
 }
 
+static cell_t ws_SetBatchMessageCallback(IPluginContext *pContext, const cell_t *params)
+{
+	WebSocketServer *pWebsocketServer = GetWsServerPointer(pContext, params[1]);
+
+	if (!pWebsocketServer)
+	{
+		return 0;
+	}
+
+	IPluginFunction *callback = pContext->GetFunctionById(params[2]);
+
+	if (pWebsocketServer->pBatchForward) {
+		forwards->ReleaseForward(pWebsocketServer->pBatchForward);
+	}
+
+	pWebsocketServer->pBatchForward = forwards->CreateForwardEx(nullptr, ET_Ignore, 3, nullptr, Param_Cell, Param_Cell, Param_Cell);
+	if (!pWebsocketServer->pBatchForward || !pWebsocketServer->pBatchForward->AddFunction(callback))
+	{
+		pContext->ReportError("Could not create batch message forward.");
+		return 0;
+	}
+
+	return 1;
+}
+
+static cell_t ws_SetBinaryMessageCallback(IPluginContext *pContext, const cell_t *params)
+{
+	WebSocketServer *pWebsocketServer = GetWsServerPointer(pContext, params[1]);
+
+	if (!pWebsocketServer)
+	{
+		return 0;
+	}
+
+	IPluginFunction *callback = pContext->GetFunctionById(params[2]);
+
+	if (pWebsocketServer->pBinaryForward) {
+		forwards->ReleaseForward(pWebsocketServer->pBinaryForward);
+	}
+
+	pWebsocketServer->pBinaryForward = forwards->CreateForwardEx(nullptr, ET_Ignore, 6, nullptr, Param_Cell, Param_String, Param_Cell, Param_String, Param_String, Param_Cell);
+	if (!pWebsocketServer->pBinaryForward || !pWebsocketServer->pBinaryForward->AddFunction(callback))
+	{
+		pContext->ReportError("Could not create binary message forward.");
+		return 0;
+	}
+
+	return 1;
+}
+
+static cell_t ws_SetDropCallback(IPluginContext *pContext, const cell_t *params)
+{
+	WebSocketServer *pWebsocketServer = GetWsServerPointer(pContext, params[1]);
+
+	if (!pWebsocketServer)
+	{
+		return 0;
+	}
+
+	IPluginFunction *callback = pContext->GetFunctionById(params[2]);
+
+	if (pWebsocketServer->pDropForward) {
+		forwards->ReleaseForward(pWebsocketServer->pDropForward);
+	}
+
+	pWebsocketServer->pDropForward = forwards->CreateForwardEx(nullptr, ET_Ignore, 2, nullptr, Param_Cell, Param_Cell);
+	if (!pWebsocketServer->pDropForward || !pWebsocketServer->pDropForward->AddFunction(callback))
+	{
+		pContext->ReportError("Could not create drop forward.");
+		return 0;
+	}
+
+	return 1;
+}
+
+static cell_t ws_SetQueueLimit(IPluginContext *pContext, const cell_t *params)
+{
+	WebSocketServer *pWebsocketServer = GetWsServerPointer(pContext, params[1]);
+
+	if (!pWebsocketServer)
+	{
+		return 0;
+	}
+
+	if (params[2] < 0 || params[3] < QueuePolicy_DropOldest || params[3] > QueuePolicy_Pause)
+	{
+		pContext->ReportError("Invalid queue limit %d or policy %d", params[2], params[3]);
+		return 0;
+	}
+
+	pWebsocketServer->SetQueueLimit(params[2], static_cast<QueuePolicy>(params[3]));
+
+	return 1;
+}
+
+static cell_t ws_AddFilter(IPluginContext *pContext, const cell_t *params)
+{
+	WebSocketServer *pWebsocketServer = GetWsServerPointer(pContext, params[1]);
+
+	if (!pWebsocketServer)
+	{
+		return 0;
+	}
+
+	if (params[4] < FilterMatch_Equals || params[4] > FilterMatch_Prefix)
+	{
+		pContext->ReportError("Invalid filter match %d", params[4]);
+		return 0;
+	}
+
+	char *pointer, *value;
+	pContext->LocalToString(params[2], &pointer);
+	pContext->LocalToString(params[3], &value);
+
+	std::string error;
+	if (!pWebsocketServer->m_filter.AddRule(pointer, value, static_cast<FilterMatch>(params[4]), error))
+	{
+		pContext->ReportError("Invalid filter \"%s\": %s", pointer, error.c_str());
+		return 0;
+	}
+
+	return 1;
+}
+
+static cell_t ws_ClearFilters(IPluginContext *pContext, const cell_t *params)
+{
+	WebSocketServer *pWebsocketServer = GetWsServerPointer(pContext, params[1]);
+
+	if (!pWebsocketServer)
+	{
+		return 0;
+	}
+
+	pWebsocketServer->m_filter.Clear();
+
+	return 1;
+}
+
+static cell_t ws_Filtering(IPluginContext *pContext, const cell_t *params)
+{
+	WebSocketServer *pWebsocketServer = GetWsServerPointer(pContext, params[1]);
+
+	if (!pWebsocketServer)
+	{
+		return 0;
+	}
+
+	if (params[0] == 2) {
+		if (params[2] < FilterMode_Allow || params[2] > FilterMode_Deny)
+		{
+			pContext->ReportError("Invalid filter mode %d", params[2]);
+			return 0;
+		}
+
+		pWebsocketServer->m_filter.SetMode(static_cast<FilterMode>(params[2]));
+		return 1;
+	}
+
+	return pWebsocketServer->m_filter.GetMode();
+}
+
+static cell_t ws_GetFilteredMessages(IPluginContext *pContext, const cell_t *params)
+{
+	WebSocketServer *pWebsocketServer = GetWsServerPointer(pContext, params[1]);
+
+	if (!pWebsocketServer)
+	{
+		return 0;
+	}
+
+	return static_cast<cell_t>(pWebsocketServer->m_filter.GetFiltered());
+}
+
+static cell_t ws_GetQueuedMessages(IPluginContext *pContext, const cell_t *params)
+{
+	WebSocketServer *pWebsocketServer = GetWsServerPointer(pContext, params[1]);
+
+	if (!pWebsocketServer)
+	{
+		return 0;
+	}
+
+	return static_cast<cell_t>(pWebsocketServer->GetQueued());
+}
+
 static cell_t ws_Start(IPluginContext *pContext, const cell_t *params)
 {
 	WebSocketServer* pWebsocketServer = GetWsServerPointer(pContext, params[1]);
@@ -152,6 +337,7 @@ static cell_t ws_Start(IPluginContext *pContext, const cell_t *params)
 		return 0;
 	}
 
+	pWebsocketServer->Resume();
 	pWebsocketServer->m_webSocketServer.start();
 
 	return 1;
@@ -166,6 +352,7 @@ static cell_t ws_Stop(IPluginContext *pContext, const cell_t *params)
 		return 0;
 	}
 
+	pWebsocketServer->Interrupt();
 	pWebsocketServer->m_webSocketServer.stop();
 
 	return 1;
@@ -187,6 +374,27 @@ static cell_t ws_SendMessageToClient(IPluginContext *pContext, const cell_t *par
 	return pWebsocketServer->sendToClient(clientId, msg);
 }
 
+static cell_t ws_SendBinaryToClient(IPluginContext *pContext, const cell_t *params)
+{
+	WebSocketServer* pWebsocketServer = GetWsServerPointer(pContext, params[1]);
+
+	if (!pWebsocketServer)
+	{
+		return 0;
+	}
+
+	char *clientId;
+	pContext->LocalToString(params[2], &clientId);
+	char *data = g_WebsocketExt.GetBinaryPointer(pContext, params[3], params[4]);
+
+	if (!data)
+	{
+		return 0;
+	}
+
+	return pWebsocketServer->sendBinaryToClient(clientId, data, params[4]);
+}
+
 static cell_t ws_DisconnectClient(IPluginContext *pContext, const cell_t *params)
 {
 	WebSocketServer* pWebsocketServer = GetWsServerPointer(pContext, params[1]);
@@ -219,6 +427,204 @@ static cell_t ws_BroadcastMessage(IPluginContext *pContext, const cell_t *params
 	return 1;
 }
 
+static cell_t ws_BroadcastBinary(IPluginContext *pContext, const cell_t *params)
+{
+	WebSocketServer* pWebsocketServer = GetWsServerPointer(pContext, params[1]);
+
+	if (!pWebsocketServer)
+	{
+		return 0;
+	}
+
+	char *data = g_WebsocketExt.GetBinaryPointer(pContext, params[2], params[3]);
+
+	if (!data)
+	{
+		return 0;
+	}
+
+	pWebsocketServer->broadcastBinary(data, params[3]);
+
+	return 1;
+}
+
+static cell_t ws_SendMessageToConnection(IPluginContext *pContext, const cell_t *params)
+{
+	WebSocketServer* pWebsocketServer = GetWsServerPointer(pContext, params[1]);
+
+	if (!pWebsocketServer)
+	{
+		return 0;
+	}
+
+	char *msg;
+	pContext->LocalToString(params[3], &msg);
+
+	return pWebsocketServer->sendToConnection(params[2], msg);
+}
+
+static cell_t ws_SendBinaryToConnection(IPluginContext *pContext, const cell_t *params)
+{
+	WebSocketServer* pWebsocketServer = GetWsServerPointer(pContext, params[1]);
+
+	if (!pWebsocketServer)
+	{
+		return 0;
+	}
+
+	char *data = g_WebsocketExt.GetBinaryPointer(pContext, params[3], params[4]);
+
+	if (!data)
+	{
+		return 0;
+	}
+
+	return pWebsocketServer->sendBinaryToConnection(params[2], data, params[4]);
+}
+
+static cell_t ws_DisconnectConnection(IPluginContext *pContext, const cell_t *params)
+{
+	WebSocketServer* pWebsocketServer = GetWsServerPointer(pContext, params[1]);
+
+	if (!pWebsocketServer)
+	{
+		return 0;
+	}
+
+	return pWebsocketServer->disconnectConnection(params[2]);
+}
+
+static cell_t ws_GetConnectionClientId(IPluginContext *pContext, const cell_t *params)
+{
+	WebSocketServer* pWebsocketServer = GetWsServerPointer(pContext, params[1]);
+
+	if (!pWebsocketServer)
+	{
+		return 0;
+	}
+
+	std::string id;
+	if (!pWebsocketServer->getConnectionClientId(params[2], id))
+	{
+		return 0;
+	}
+
+	pContext->StringToLocal(params[3], params[4], id.c_str());
+
+	return 1;
+}
+
+static cell_t ws_GetClientConnection(IPluginContext *pContext, const cell_t *params)
+{
+	WebSocketServer* pWebsocketServer = GetWsServerPointer(pContext, params[1]);
+
+	if (!pWebsocketServer)
+	{
+		return -1;
+	}
+
+	char *clientId;
+	pContext->LocalToString(params[2], &clientId);
+
+	return pWebsocketServer->getClientConnection(clientId);
+}
+
+static cell_t ws_GetMaxSlots(IPluginContext *pContext, const cell_t *params)
+{
+	WebSocketServer* pWebsocketServer = GetWsServerPointer(pContext, params[1]);
+
+	if (!pWebsocketServer)
+	{
+		return 0;
+	}
+
+	return std::min<size_t>(pWebsocketServer->m_webSocketServer.getMaxConnections(), WebSocketServer::kMaxSlots);
+}
+
+static cell_t ws_JoinRoom(IPluginContext *pContext, const cell_t *params)
+{
+	WebSocketServer* pWebsocketServer = GetWsServerPointer(pContext, params[1]);
+
+	if (!pWebsocketServer)
+	{
+		return 0;
+	}
+
+	char *clientId, *room;
+	pContext->LocalToString(params[2], &clientId);
+	pContext->LocalToString(params[3], &room);
+
+	return pWebsocketServer->joinRoom(clientId, room);
+}
+
+static cell_t ws_LeaveRoom(IPluginContext *pContext, const cell_t *params)
+{
+	WebSocketServer* pWebsocketServer = GetWsServerPointer(pContext, params[1]);
+
+	if (!pWebsocketServer)
+	{
+		return 0;
+	}
+
+	char *clientId, *room;
+	pContext->LocalToString(params[2], &clientId);
+	pContext->LocalToString(params[3], &room);
+
+	return pWebsocketServer->leaveRoom(clientId, room);
+}
+
+static cell_t ws_PublishToRoom(IPluginContext *pContext, const cell_t *params)
+{
+	WebSocketServer* pWebsocketServer = GetWsServerPointer(pContext, params[1]);
+
+	if (!pWebsocketServer)
+	{
+		return 0;
+	}
+
+	char *room, *msg;
+	pContext->LocalToString(params[2], &room);
+	pContext->LocalToString(params[3], &msg);
+
+	return pWebsocketServer->publishToRoom(room, msg);
+}
+
+static cell_t ws_PublishBinaryToRoom(IPluginContext *pContext, const cell_t *params)
+{
+	WebSocketServer* pWebsocketServer = GetWsServerPointer(pContext, params[1]);
+
+	if (!pWebsocketServer)
+	{
+		return 0;
+	}
+
+	char *room;
+	pContext->LocalToString(params[2], &room);
+	char *data = g_WebsocketExt.GetBinaryPointer(pContext, params[3], params[4]);
+
+	if (!data)
+	{
+		return 0;
+	}
+
+	return pWebsocketServer->publishBinaryToRoom(room, data, params[4]);
+}
+
+static cell_t ws_GetRoomSize(IPluginContext *pContext, const cell_t *params)
+{
+	WebSocketServer* pWebsocketServer = GetWsServerPointer(pContext, params[1]);
+
+	if (!pWebsocketServer)
+	{
+		return 0;
+	}
+
+	char *room;
+	pContext->LocalToString(params[2], &room);
+
+	return pWebsocketServer->getRoomSize(room);
+}
+
 static cell_t ws_GetClientsCount(IPluginContext *pContext, const cell_t *params)
 {
 	WebSocketServer* pWebsocketServer = GetWsServerPointer(pContext, params[1]);
@@ -228,7 +634,7 @@ static cell_t ws_GetClientsCount(IPluginContext *pContext, const cell_t *params)
 		return 0;
 	}
 
-	return pWebsocketServer->m_webSocketServer.getClients().size();
+	return pWebsocketServer->getClientCount();
 }
 
 static cell_t ws_SetOrGetPongEnable(IPluginContext *pContext, const cell_t *params)
@@ -267,6 +673,67 @@ static cell_t ws_DisableDeflate(IPluginContext *pContext, const cell_t *params)
 	return 1;
 }
 
+static cell_t ws_ConfigureDeflate(IPluginContext *pContext, const cell_t *params)
+{
+	WebSocketServer* pWebsocketServer = GetWsServerPointer(pContext, params[1]);
+
+	if (!pWebsocketServer)
+	{
+		return 0;
+	}
+
+	int level = params[2], minSize = params[3], windowBits = params[4], peerWindowBits = params[6];
+
+	if (level < -1 || level > 9 || minSize < 0 || windowBits < 8 || windowBits > 15 || peerWindowBits < 8 || peerWindowBits > 15)
+	{
+		pContext->ReportError("Invalid deflate options: level %d, min size %d, window bits %d, peer window bits %d", level, minSize, windowBits, peerWindowBits);
+		return 0;
+	}
+
+	// the server side of the negotiation, client offers are capped to these
+	ix::WebSocketPerMessageDeflateOptions options(true, params[7] != 0, params[5] != 0, peerWindowBits, windowBits);
+	options.setCompressionLevel(level);
+	options.setMinCompressSize(minSize);
+
+	pWebsocketServer->m_webSocketServer.setPerMessageDeflateOptions(options);
+
+	return 1;
+}
+
+static cell_t ws_UseEventLoop(IPluginContext *pContext, const cell_t *params)
+{
+	WebSocketServer* pWebsocketServer = GetWsServerPointer(pContext, params[1]);
+
+	if (!pWebsocketServer)
+	{
+		return 0;
+	}
+
+	if (pWebsocketServer->m_webSocketServer.isListening())
+	{
+		pContext->ReportError("Event loops must be set up before the server is started");
+		return 0;
+	}
+
+	int threads = params[2], maxConnections = params[3];
+	int handshakeThreads = params[0] >= 4 ? params[4] : 2;
+
+	if (threads < 1 || threads > 64 || maxConnections < 1 || maxConnections > WebSocketServer::kMaxSlots || handshakeThreads < 1 || handshakeThreads > 64)
+	{
+		pContext->ReportError("Invalid event loop options: threads %d, max connections %d, handshake threads %d", threads, maxConnections, handshakeThreads);
+		return 0;
+	}
+
+	if (!pWebsocketServer->m_webSocketServer.enableEventLoop(threads, handshakeThreads))
+	{
+		return 0;
+	}
+
+	pWebsocketServer->m_webSocketServer.setMaxConnections(maxConnections);
+
+	return 1;
+}
+
 static cell_t ws_IsDeflateEnabled(IPluginContext *pContext, const cell_t *params)
 {
 	WebSocketServer* pWebsocketServer = GetWsServerPointer(pContext, params[1]);
@@ -292,19 +759,13 @@ static cell_t ws_GetHeader(IPluginContext *pContext, const cell_t *params)
 	pContext->LocalToString(params[2], &clientId);
 	pContext->LocalToString(params[3], &headerKey);
 
-	ix::WebSocketHttpHeaders headers;
-	if (!pWebsocketServer->getClientHeaders(clientId, headers))
-	{
-		return 0;
-	}
-
-	auto it = headers.find(headerKey);
-	if (it == headers.end())
+	std::string value;
+	if (!pWebsocketServer->getClientHeader(clientId, headerKey, value))
 	{
 		return 0;
 	}
 
-	pContext->StringToLocal(params[4], params[5], it->second.c_str());
+	pContext->StringToLocal(params[4], params[5], value.c_str());
 
 	return 1;
 }
@@ -318,14 +779,14 @@ static cell_t ws_GetClientIdByIndex(IPluginContext *pContext, const cell_t *para
 	}
 
 	cell_t index = params[2];
-	const auto& ids = pWebsocketServer->getClientIds();
+	std::string id;
 
-	if (index < 0 || static_cast<size_t>(index) >= ids.size())
+	if (index < 0 || !pWebsocketServer->getClientId(static_cast<size_t>(index), id))
 	{
 		return 0;
 	}
 
-	pContext->StringToLocal(params[3], params[4], ids[index].c_str());
+	pContext->StringToLocal(params[3], params[4], id.c_str());
 
 	return 1;
 }
@@ -350,6 +811,23 @@ static cell_t ws_GetMaxClientIdLength(IPluginContext *pContext, const cell_t *pa
 	return static_cast<cell_t>(maxLen + 1);
 }
 
+static cell_t ws_HighPriority(IPluginContext *pContext, const cell_t *params)
+{
+	WebSocketServer *pWebsocketServer = GetWsServerPointer(pContext, params[1]);
+
+	if (!pWebsocketServer)
+	{
+		return 0;
+	}
+
+	if (params[0] == 2) {
+		pWebsocketServer->SetHighPriority(params[2]);
+		return 1;
+	}
+
+	return pWebsocketServer->IsHighPriority();
+}
+
 const sp_nativeinfo_t ws_natives_server[] =
 {
 	{"WebSocketServer.WebSocketServer",        ws_CreateWebSocketServer},
@@ -357,11 +835,36 @@ const sp_nativeinfo_t ws_natives_server[] =
 	{"WebSocketServer.SetOpenCallback",        ws_SetOpenCallback},
 	{"WebSocketServer.SetCloseCallback",       ws_SetCloseCallback},
 	{"WebSocketServer.SetErrorCallback",       ws_SetErrorCallback},
+	{"WebSocketServer.SetBatchMessageCallback", ws_SetBatchMessageCallback},
+	{"WebSocketServer.SetBinaryMessageCallback", ws_SetBinaryMessageCallback},
+	{"WebSocketServer.SetDropCallback",        ws_SetDropCallback},
+	{"WebSocketServer.SetQueueLimit",          ws_SetQueueLimit},
+	{"WebSocketServer.QueuedMessages.get",     ws_GetQueuedMessages},
+	{"WebSocketServer.AddFilter",              ws_AddFilter},
+	{"WebSocketServer.ClearFilters",           ws_ClearFilters},
+	{"WebSocketServer.Filtering.get",          ws_Filtering},
+	{"WebSocketServer.Filtering.set",          ws_Filtering},
+	{"WebSocketServer.FilteredMessages.get",   ws_GetFilteredMessages},
+	{"WebSocketServer.HighPriority.get",       ws_HighPriority},
+	{"WebSocketServer.HighPriority.set",       ws_HighPriority},
 	{"WebSocketServer.Start",                  ws_Start},
 	{"WebSocketServer.Stop",                   ws_Stop},
 	{"WebSocketServer.BroadcastMessage",       ws_BroadcastMessage},
 	{"WebSocketServer.SendMessageToClient",    ws_SendMessageToClient},
+	{"WebSocketServer.BroadcastBinary",        ws_BroadcastBinary},
+	{"WebSocketServer.SendBinaryToClient",     ws_SendBinaryToClient},
 	{"WebSocketServer.DisconnectClient",       ws_DisconnectClient},
+	{"WebSocketServer.SendMessageToConnection", ws_SendMessageToConnection},
+	{"WebSocketServer.SendBinaryToConnection", ws_SendBinaryToConnection},
+	{"WebSocketServer.DisconnectConnection",   ws_DisconnectConnection},
+	{"WebSocketServer.GetConnectionClientId",  ws_GetConnectionClientId},
+	{"WebSocketServer.GetClientConnection",    ws_GetClientConnection},
+	{"WebSocketServer.MaxSlots.get",           ws_GetMaxSlots},
+	{"WebSocketServer.JoinRoom",               ws_JoinRoom},
+	{"WebSocketServer.LeaveRoom",              ws_LeaveRoom},
+	{"WebSocketServer.PublishToRoom",          ws_PublishToRoom},
+	{"WebSocketServer.PublishBinaryToRoom",    ws_PublishBinaryToRoom},
+	{"WebSocketServer.GetRoomSize",            ws_GetRoomSize},
 	{"WebSocketServer.GetHeader",              ws_GetHeader},
 	{"WebSocketServer.ClientsCount.get",       ws_GetClientsCount},
 	{"WebSocketServer.EnablePong.get",         ws_SetOrGetPongEnable},
@@ -369,6 +872,8 @@ const sp_nativeinfo_t ws_natives_server[] =
 	{"WebSocketServer.GetClientIdByIndex",     ws_GetClientIdByIndex},
 	{"WebSocketServer.MaxClientIdLength.get",  ws_GetMaxClientIdLength},
 	{"WebSocketServer.DisableDeflate",         ws_DisableDeflate},
+	{"WebSocketServer.ConfigureDeflate",       ws_ConfigureDeflate},
 	{"WebSocketServer.IsDeflateEnabled",       ws_IsDeflateEnabled},
+	{"WebSocketServer.UseEventLoop",           ws_UseEventLoop},
 	{nullptr, nullptr}
 };
\ No newline at end of file
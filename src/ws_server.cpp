@@ -9,93 +9,168 @@ WebSocketServer::WebSocketServer(const std::string& host, int port, int addressF
 	addressFamily,
 	pingInterval)
 {
-	m_webSocketServer.setOnClientMessageCallback([this](std::shared_ptr<ix::ConnectionState> connectionState, ix::WebSocket& webSocket, const ix::WebSocketMessagePtr& msg) {
-		switch (msg->type)
-		{
-			case ix::WebSocketMessageType::Open:
-			{
-				OnOpen(msg->openInfo, connectionState);
-				break;
-			}
-			case ix::WebSocketMessageType::Message:
-			{
-				OnMessage(msg->str, connectionState, &webSocket);
-				break;
-			}
-			case ix::WebSocketMessageType::Close:
-			{
-				OnClose(msg->closeInfo, connectionState);
-				break;
-			}
-			case ix::WebSocketMessageType::Error:
+	m_webSocketServer.setConnectionStateFactory([] { return std::make_shared<ServerConnectionState>(); });
+
+	// the connection callback hands out the socket itself, which the client index keeps a weak reference to
+	m_webSocketServer.setOnConnectionCallback([this](std::weak_ptr<ix::WebSocket> weakWebSocket, std::shared_ptr<ix::ConnectionState> connectionState) {
+		auto webSocket = weakWebSocket.lock();
+		if (!webSocket) return;
+
+		auto state = static_cast<ServerConnectionState*>(connectionState.get());
+		state->m_remoteAddress = connectionState->getRemoteIp() + ":" + std::to_string(connectionState->getRemotePort());
+
+		webSocket->setOnMessageCallback([this, weakWebSocket, connectionState](const ix::WebSocketMessagePtr& msg) {
+			switch (msg->type)
 			{
-				OnError(msg->errorInfo, connectionState);
-				break;
+				case ix::WebSocketMessageType::Open:
+				{
+					OnOpen(msg->openInfo, connectionState, weakWebSocket);
+					break;
+				}
+				case ix::WebSocketMessageType::Message:
+				{
+					msg->binary ? OnBinaryMessage(TakePayload(msg), connectionState, weakWebSocket) : OnMessage(TakePayload(msg), connectionState, weakWebSocket);
+					break;
+				}
+				case ix::WebSocketMessageType::Close:
+				{
+					OnClose(msg->closeInfo, connectionState);
+					break;
+				}
+				case ix::WebSocketMessageType::Error:
+				{
+					OnError(msg->errorInfo, connectionState);
+					break;
+				}
 			}
-		}
+		});
 	});
 }
 
 WebSocketServer::~WebSocketServer() 
 {
+	Interrupt();
 	m_webSocketServer.stop();
 
+	HandleSecurity sec(nullptr, myself->GetIdentity());
+	for (const auto& [connectionState, client] : m_connectionClients)
+	{
+		handlesys->FreeHandle(client->m_websocket_handle, &sec);
+	}
+
 	if (pMessageForward) forwards->ReleaseForward(pMessageForward);
 	if (pOpenForward) forwards->ReleaseForward(pOpenForward);
 	if (pCloseForward) forwards->ReleaseForward(pCloseForward);
 	if (pErrorForward) forwards->ReleaseForward(pErrorForward);
+	if (pBatchForward) forwards->ReleaseForward(pBatchForward);
+	if (pBinaryForward) forwards->ReleaseForward(pBinaryForward);
 }
 
-void WebSocketServer::OnMessage(const std::string& message, std::shared_ptr<ix::ConnectionState> connectionState, ix::WebSocket* client) 
+void WebSocketServer::OnMessage(std::string&& message, std::shared_ptr<ix::ConnectionState> connectionState, const std::weak_ptr<ix::WebSocket>& client) 
 {
-	if (!pMessageForward || !pMessageForward->GetFunctionCount())
+	bool batched = pBatchForward && pBatchForward->GetFunctionCount();
+
+	if (!batched && (!pMessageForward || !pMessageForward->GetFunctionCount()))
 	{
 		return;
 	}
 
-	WsServerMessageTaskContext *context = new WsServerMessageTaskContext(this, message, connectionState, client);
-	g_WebsocketExt.AddTaskToQueue(context);
+	if (m_filter.IsActive() && !m_filter.Accept(message))
+	{
+		return;
+	}
+
+	uint64_t seq;
+	if (!Admit(seq))
+	{
+		return;
+	}
+
+	if (batched)
+	{
+		BatchedMessage entry;
+		entry.message = std::move(message);
+		entry.seq = seq;
+		entry.connectionState = connectionState;
+
+		if (m_batch.Add(std::move(entry)))
+		{
+			WsServerBatchTaskContext *context = new WsServerBatchTaskContext(this);
+			Queue(context, GetDataLane());
+		}
+		return;
+	}
+
+	// the callback runs on the game thread, after the server may have let go of the connection
+	WsServerMessageTaskContext *context = new WsServerMessageTaskContext(this, std::move(message), connectionState, client.lock(), seq);
+	Queue(context, GetDataLane());
 }
 
-void WebSocketServer::OnOpen(ix::WebSocketOpenInfo openInfo, std::shared_ptr<ix::ConnectionState> connectionState) 
+void WebSocketServer::OnBinaryMessage(std::string&& message, std::shared_ptr<ix::ConnectionState> connectionState, const std::weak_ptr<ix::WebSocket>& client) 
 {
-	if (!pOpenForward || !pOpenForward->GetFunctionCount())
+	// without a binary callback, binary frames are delivered like text
+	if (!pBinaryForward || !pBinaryForward->GetFunctionCount())
 	{
+		OnMessage(std::move(message), connectionState, client);
 		return;
 	}
 
-	WsServerOpenTaskContext *context = new WsServerOpenTaskContext(this, openInfo, connectionState);
-	g_WebsocketExt.AddTaskToQueue(context);
+	uint64_t seq;
+	if (!Admit(seq))
+	{
+		return;
+	}
+
+	WsServerBinaryTaskContext *context = new WsServerBinaryTaskContext(this, std::move(message), connectionState, seq);
+	Queue(context, GetDataLane());
 }
 
-void WebSocketServer::OnClose(ix::WebSocketCloseInfo closeInfo, std::shared_ptr<ix::ConnectionState> connectionState) 
+void WebSocketServer::OnOpen(ix::WebSocketOpenInfo openInfo, std::shared_ptr<ix::ConnectionState> connectionState, std::weak_ptr<ix::WebSocket> client) 
 {
-	if (!pCloseForward || !pCloseForward->GetFunctionCount())
+	// indexed before the open callback runs, so it can already send to the client
+	int connection = AddClient(connectionState->getId(), client, openInfo.headers);
+	static_cast<ServerConnectionState*>(connectionState.get())->m_connection.store(connection, std::memory_order_relaxed);
+
+	if (!pOpenForward || !pOpenForward->GetFunctionCount())
 	{
 		return;
 	}
 
+	WsServerOpenTaskContext *context = new WsServerOpenTaskContext(this, openInfo, connectionState);
+	Queue(context, TaskLane_Control);
+}
+
+void WebSocketServer::OnClose(ix::WebSocketCloseInfo closeInfo, std::shared_ptr<ix::ConnectionState> connectionState) 
+{
+	RemoveClient(connectionState->getId());
+
+	// queued even without a close callback, it releases the client handle after the connection's messages
 	WsServerCloseTaskContext *context = new WsServerCloseTaskContext(this, closeInfo, connectionState);
-	g_WebsocketExt.AddTaskToQueue(context);
+	Queue(context, TaskLane_Control);
 }
 
 void WebSocketServer::OnError(ix::WebSocketErrorInfo errorInfo, std::shared_ptr<ix::ConnectionState> connectionState) 
 {
-	if (!pErrorForward || !pErrorForward->GetFunctionCount())
-	{
-		return;
-	}
+	RemoveClient(connectionState->getId());
 
 	WsServerErrorTaskContext *context = new WsServerErrorTaskContext(this, errorInfo, connectionState);
-	g_WebsocketExt.AddTaskToQueue(context);
+	Queue(context, TaskLane_Control);
 }
 
 void WebSocketServer::broadcastMessage(const std::string& message) {
-	auto clients = m_webSocketServer.getClients();
+	broadcastPrepared(ix::WebSocketPreparedMessage(message, false));
+}
+
+void WebSocketServer::broadcastBinary(const char* data, size_t length) {
+	broadcastPrepared(ix::WebSocketPreparedMessage(std::string(data, length), true));
+}
 
-	for (const auto& client : clients)
+void WebSocketServer::broadcastPrepared(const ix::WebSocketPreparedMessage& message) {
+	// framed once, and compressed once per deflate setting for clients without context takeover,
+	// what a socket does not take right away is flushed by its network thread
+	for (const auto& client : GetClientSockets())
 	{
-		client.first->send(message);
+		client->sendPrepared(message);
 	} 
 }
 
@@ -108,6 +183,113 @@ bool WebSocketServer::sendToClient(const std::string& clientId, const std::strin
 	return true;
 }
 
+bool WebSocketServer::sendBinaryToClient(const std::string& clientId, const char* data, size_t length) {
+	auto client = GetClientById(clientId);
+	if (!client) return false;
+
+	client->sendBinary(ix::IXWebSocketSendData(data, length));
+
+	return true;
+}
+
+bool WebSocketServer::joinRoom(const std::string& clientId, const std::string& room) {
+	std::lock_guard<std::mutex> lock(m_clientsMutex);
+	auto it = m_clients.find(clientId);
+	if (it == m_clients.end()) return false;
+
+	it->second.rooms.insert(room);
+	m_rooms[room].insert(clientId);
+
+	return true;
+}
+
+bool WebSocketServer::leaveRoom(const std::string& clientId, const std::string& room) {
+	std::lock_guard<std::mutex> lock(m_clientsMutex);
+	auto it = m_clients.find(clientId);
+	if (it == m_clients.end() || !it->second.rooms.erase(room)) return false;
+
+	auto members = m_rooms.find(room);
+	members->second.erase(clientId);
+	if (members->second.empty())
+	{
+		m_rooms.erase(members);
+	}
+
+	return true;
+}
+
+size_t WebSocketServer::publishToRoom(const std::string& room, const std::string& message) {
+	return publishPrepared(room, ix::WebSocketPreparedMessage(message, false));
+}
+
+size_t WebSocketServer::publishBinaryToRoom(const std::string& room, const char* data, size_t length) {
+	return publishPrepared(room, ix::WebSocketPreparedMessage(std::string(data, length), true));
+}
+
+size_t WebSocketServer::publishPrepared(const std::string& room, const ix::WebSocketPreparedMessage& message) {
+	size_t sent = 0;
+	for (const auto& client : GetRoomSockets(room))
+	{
+		if (client->sendPrepared(message).success)
+		{
+			sent++;
+		}
+	}
+
+	return sent;
+}
+
+size_t WebSocketServer::getRoomSize(const std::string& room) {
+	std::lock_guard<std::mutex> lock(m_clientsMutex);
+	auto it = m_rooms.find(room);
+	return it != m_rooms.end() ? it->second.size() : 0;
+}
+
+bool WebSocketServer::sendToConnection(int connection, const std::string& message) {
+	auto client = GetClientByConnection(connection);
+	if (!client) return false;
+
+	client->send(message);
+
+	return true;
+}
+
+bool WebSocketServer::sendBinaryToConnection(int connection, const char* data, size_t length) {
+	auto client = GetClientByConnection(connection);
+	if (!client) return false;
+
+	client->sendBinary(ix::IXWebSocketSendData(data, length));
+
+	return true;
+}
+
+bool WebSocketServer::disconnectConnection(int connection) {
+	auto client = GetClientByConnection(connection);
+	if (!client) return false;
+
+	client->stop();
+
+	return true;
+}
+
+bool WebSocketServer::getConnectionClientId(int connection, std::string& outId) {
+	std::lock_guard<std::mutex> lock(m_clientsMutex);
+	Slot* slot = FindSlot(connection);
+	if (!slot) return false;
+
+	outId = slot->clientId;
+
+	return true;
+}
+
+int WebSocketServer::getClientConnection(const std::string& clientId) {
+	std::lock_guard<std::mutex> lock(m_clientsMutex);
+	auto it = m_clients.find(clientId);
+	if (it == m_clients.end()) return -1;
+
+	return it->second.connection;
+}
+
 bool WebSocketServer::disconnectClient(const std::string& clientId) {
 	auto client = GetClientById(clientId);
 	if (!client) return false;
@@ -118,109 +300,393 @@ bool WebSocketServer::disconnectClient(const std::string& clientId) {
 }
 
 std::vector<std::string> WebSocketServer::getClientIds() {
-	std::vector<std::string> clientIds;
+	std::lock_guard<std::mutex> lock(m_clientsMutex);
+	return m_clientIds;
+}
 
-	auto clients = m_webSocketServer.getClients();
+bool WebSocketServer::getClientId(size_t index, std::string& outId) {
+	std::lock_guard<std::mutex> lock(m_clientsMutex);
+	if (index >= m_clientIds.size())
+		return false;
 
-	for (const auto& client : clients) {
-		clientIds.push_back(client.second);
-	}
+	outId = m_clientIds[index];
+	return true;
+}
 
-	return clientIds;
+size_t WebSocketServer::getClientCount() {
+	std::lock_guard<std::mutex> lock(m_clientsMutex);
+	return m_clientIds.size();
 }
 
 bool WebSocketServer::getClientHeaders(const std::string& clientId, ix::WebSocketHttpHeaders& outHeaders)
 {
-	auto client = GetClientById(clientId);
-	if (!client)
+	std::lock_guard<std::mutex> lock(m_clientsMutex);
+	auto it = m_clients.find(clientId);
+	if (it == m_clients.end())
+		return false;
+
+	outHeaders = it->second.headers;
+	return true;
+}
+
+bool WebSocketServer::getClientHeader(const std::string& clientId, const std::string& key, std::string& outValue)
+{
+	std::lock_guard<std::mutex> lock(m_clientsMutex);
+	auto it = m_clients.find(clientId);
+	if (it == m_clients.end())
+		return false;
+
+	auto header = it->second.headers.find(key);
+	if (header == it->second.headers.end())
 		return false;
 
-	std::lock_guard<std::mutex> lock(m_headersMutex);
-	auto it = m_connectionHeaders.find(clientId);
-	if (it != m_connectionHeaders.end())
+	outValue = header->second;
+	return true;
+}
+
+std::shared_ptr<ix::WebSocket> WebSocketServer::GetClientById(const std::string& clientId)
+{
+	std::lock_guard<std::mutex> lock(m_clientsMutex);
+	auto it = m_clients.find(clientId);
+	if (it == m_clients.end())
+		return nullptr;
+
+	return it->second.socket.lock();
+}
+
+int WebSocketServer::AddClient(const std::string& clientId, std::weak_ptr<ix::WebSocket> client, const ix::WebSocketHttpHeaders& headers)
+{
+	std::lock_guard<std::mutex> lock(m_clientsMutex);
+	auto [it, inserted] = m_clients.try_emplace(clientId);
+	if (inserted)
 	{
-		outHeaders = it->second;
-		return true;
+		it->second.position = m_clientIds.size();
+		m_clientIds.push_back(clientId);
+
+		// freed slots first, so slots stay below the peak number of clients
+		int slot = -1;
+		if (!m_freeSlots.empty())
+		{
+			slot = m_freeSlots.back();
+			m_freeSlots.pop_back();
+		}
+		else if (m_slots.size() < kMaxSlots)
+		{
+			slot = (int)m_slots.size();
+			m_slots.emplace_back();
+		}
+
+		it->second.connection = -1;
+		if (slot != -1)
+		{
+			Slot& entry = m_slots[slot];
+			entry.socket = client;
+			entry.clientId = clientId;
+			entry.used = true;
+			it->second.connection = (entry.generation << 16) | slot;
+		}
 	}
-	
-	return false;
+
+	it->second.socket = std::move(client);
+	it->second.headers = headers;
+
+	return it->second.connection;
 }
 
-void WsServerMessageTaskContext::OnCompleted()
+void WebSocketServer::RemoveClient(const std::string& clientId)
+{
+	std::lock_guard<std::mutex> lock(m_clientsMutex);
+	auto it = m_clients.find(clientId);
+	if (it == m_clients.end())
+		return;
+
+	// move the last id into the freed slot, which changes the index of one other client
+	size_t position = it->second.position;
+	if (position != m_clientIds.size() - 1)
+	{
+		m_clientIds[position] = std::move(m_clientIds.back());
+		m_clients[m_clientIds[position]].position = position;
+	}
+
+	m_clientIds.pop_back();
+
+	if (Slot* slot = FindSlot(it->second.connection))
+	{
+		// connections still held by plugins stop matching the slot
+		slot->socket.reset();
+		slot->clientId.clear();
+		slot->used = false;
+		slot->generation = slot->generation % 0x7FFF + 1;
+
+		m_freeSlots.push_back(it->second.connection & 0xFFFF);
+	}
+
+	for (const auto& room : it->second.rooms)
+	{
+		auto members = m_rooms.find(room);
+		members->second.erase(clientId);
+		if (members->second.empty())
+		{
+			m_rooms.erase(members);
+		}
+	}
+
+	m_clients.erase(it);
+}
+
+WebSocketClient* WebSocketServer::GetConnectionClient(const std::shared_ptr<ix::ConnectionState>& connectionState, std::shared_ptr<ix::WebSocket> client)
 {
+	const std::string& clientId = connectionState->getId();
+
+	auto it = m_connectionClients.find(connectionState.get());
+	if (it != m_connectionClients.end())
+	{
+		return it->second;
+	}
+
+	if (!client)
+	{
+		return nullptr;
+	}
+
+	WebSocketClient* pWebSocketClient = new WebSocketClient(std::move(client));
+	getClientHeaders(clientId, pWebSocketClient->m_headers);
+
+	// plugins get to use the handle until the client disconnects, but not to free it
 	HandleError err;
 	HandleSecurity sec(nullptr, myself->GetIdentity());
+	HandleAccess access;
+	handlesys->InitAccessDefaults(nullptr, &access);
+	access.access[HandleAccess_Delete] = HANDLE_RESTRICT_IDENTITY;
+
+	pWebSocketClient->m_websocket_handle = handlesys->CreateHandleEx(g_htWsClient, pWebSocketClient, &sec, &access, &err);
+	if (!pWebSocketClient->m_websocket_handle)
+	{
+		delete pWebSocketClient;
+		return nullptr;
+	}
+
+	// the close task of the connection is queued behind its messages and releases it
+	m_connectionClients.emplace(connectionState.get(), pWebSocketClient);
+
+	return pWebSocketClient;
+}
+
+void WebSocketServer::ReleaseConnectionClient(const std::shared_ptr<ix::ConnectionState>& connectionState)
+{
+	auto it = m_connectionClients.find(connectionState.get());
+	if (it == m_connectionClients.end())
+		return;
+
+	HandleSecurity sec(nullptr, myself->GetIdentity());
+	handlesys->FreeHandle(it->second->m_websocket_handle, &sec);
+
+	m_connectionClients.erase(it);
+}
+
+WebSocketServer::Slot* WebSocketServer::FindSlot(int connection)
+{
+	if (connection < 0)
+		return nullptr;
+
+	size_t slot = connection & 0xFFFF;
+	if (slot >= m_slots.size() || !m_slots[slot].used || m_slots[slot].generation != (connection >> 16))
+		return nullptr;
 
-	WebSocketClient* pWebSocketClient = new WebSocketClient(m_client);
+	return &m_slots[slot];
+}
 
-	pWebSocketClient->m_websocket_handle = handlesys->CreateHandleEx(g_htWsClient, pWebSocketClient, &sec, nullptr, &err);
-	if (!pWebSocketClient->m_websocket_handle) return;
-	pWebSocketClient->m_keepConnecting = true;
+std::shared_ptr<ix::WebSocket> WebSocketServer::GetClientByConnection(int connection)
+{
+	std::lock_guard<std::mutex> lock(m_clientsMutex);
+	Slot* slot = FindSlot(connection);
+	if (!slot)
+		return nullptr;
 
+	return slot->socket.lock();
+}
+
+std::vector<std::shared_ptr<ix::WebSocket>> WebSocketServer::GetClientSockets()
+{
+	std::vector<std::shared_ptr<ix::WebSocket>> sockets;
+
+	std::lock_guard<std::mutex> lock(m_clientsMutex);
+	sockets.reserve(m_clients.size());
+
+	for (const auto& [id, entry] : m_clients)
+	{
+		if (auto socket = entry.socket.lock())
+		{
+			sockets.push_back(std::move(socket));
+		}
+	}
+
+	return sockets;
+}
+
+std::vector<std::shared_ptr<ix::WebSocket>> WebSocketServer::GetRoomSockets(const std::string& room)
+{
+	std::vector<std::shared_ptr<ix::WebSocket>> sockets;
+
+	std::lock_guard<std::mutex> lock(m_clientsMutex);
+	auto members = m_rooms.find(room);
+	if (members == m_rooms.end())
+		return sockets;
+
+	sockets.reserve(members->second.size());
+
+	for (const auto& clientId : members->second)
 	{
-		std::lock_guard<std::mutex> lock(m_server->m_headersMutex);
-		auto it = m_server->m_connectionHeaders.find(m_connectionState->getId());
-		if (it != m_server->m_connectionHeaders.end()) {
-			pWebSocketClient->m_headers = it->second;
+		auto it = m_clients.find(clientId);
+		if (it == m_clients.end())
+			continue;
+
+		if (auto socket = it->second.socket.lock())
+		{
+			sockets.push_back(std::move(socket));
 		}
 	}
 
-	std::string remoteAddress = WebSocketServer::GetRemoteAddress(m_connectionState);
+	return sockets;
+}
+
+void WsServerMessageTaskContext::OnCompleted()
+{
+	if (!m_server->Consume(m_seq))
+	{
+		return;
+	}
+
+	WebSocketClient* pWebSocketClient = m_server->GetConnectionClient(m_connectionState, std::move(m_client));
+	if (!pWebSocketClient) return;
+
+	const std::string& remoteAddress = WebSocketServer::GetRemoteAddress(m_connectionState);
 	m_server->pMessageForward->PushCell(m_server->m_webSocketServer_handle);
 	m_server->pMessageForward->PushCell(pWebSocketClient->m_websocket_handle);
 	m_server->pMessageForward->PushString(m_message.c_str());
 	m_server->pMessageForward->PushCell(m_message.length());
 	m_server->pMessageForward->PushString(remoteAddress.c_str());
 	m_server->pMessageForward->PushString(m_connectionState->getId().c_str());
+	m_server->pMessageForward->PushCell(WebSocketServer::GetConnection(m_connectionState));
 	m_server->pMessageForward->Execute(nullptr);
-	
-	handlesys->FreeHandle(pWebSocketClient->m_websocket_handle, nullptr);
 }
 
-void WsServerOpenTaskContext::OnCompleted()
+void WsServerBinaryTaskContext::OnCompleted()
 {
+	if (!m_server->Consume(m_seq) || !m_server->pBinaryForward)
 	{
-		std::lock_guard<std::mutex> lock(m_server->m_headersMutex);
-		m_server->m_connectionHeaders[m_connectionState->getId()] = m_openInfo.headers;
+		return;
 	}
 
-	std::string remoteAddress = WebSocketServer::GetRemoteAddress(m_connectionState);
+	const std::string& remoteAddress = WebSocketServer::GetRemoteAddress(m_connectionState);
+	m_server->pBinaryForward->PushCell(m_server->m_webSocketServer_handle);
+	m_server->pBinaryForward->PushStringEx(m_message.data(), m_message.length(), SM_PARAM_STRING_BINARY | SM_PARAM_STRING_COPY, 0);
+	m_server->pBinaryForward->PushCell(m_message.length());
+	m_server->pBinaryForward->PushString(remoteAddress.c_str());
+	m_server->pBinaryForward->PushString(m_connectionState->getId().c_str());
+	m_server->pBinaryForward->PushCell(WebSocketServer::GetConnection(m_connectionState));
+	m_server->pBinaryForward->Execute(nullptr);
+}
+
+void WsServerBatchTaskContext::OnCompleted()
+{
+	std::vector<BatchedMessage> messages;
+	m_server->m_batch.Take(messages);
+
+	yyjson_mut_doc *doc = yyjson_mut_doc_new(nullptr);
+	yyjson_mut_val *root = yyjson_mut_arr(doc);
+	yyjson_mut_doc_set_root(doc, root);
+
+	for (const auto& entry : messages)
+	{
+		if (!m_server->Consume(entry.seq))
+		{
+			continue;
+		}
+
+		const std::string& remoteAddress = WebSocketServer::GetRemoteAddress(entry.connectionState);
+		const std::string& clientId = entry.connectionState->getId();
+
+		yyjson_mut_val *item = yyjson_mut_arr_add_obj(doc, root);
+		yyjson_mut_obj_add_strncpy(doc, item, "id", clientId.c_str(), clientId.length());
+		yyjson_mut_obj_add_int(doc, item, "connection", WebSocketServer::GetConnection(entry.connectionState));
+		yyjson_mut_obj_add_strncpy(doc, item, "address", remoteAddress.c_str(), remoteAddress.length());
+		yyjson_mut_obj_add_strncpy(doc, item, "message", entry.message.c_str(), entry.message.length());
+	}
+
+	size_t count = yyjson_mut_arr_size(root);
+
+	if (!count || !m_server->pBatchForward)
+	{
+		yyjson_mut_doc_free(doc);
+		return;
+	}
+
+	auto pYYJsonWrapper = CreateWrapper();
+	pYYJsonWrapper->m_pDocument_mut = WrapDocument(doc);
+	pYYJsonWrapper->m_pVal_mut = root;
+
+	HandleError err;
+	HandleSecurity pSec(nullptr, myself->GetIdentity());
+	Handle_t batchHandle = handlesys->CreateHandleEx(g_htJSON, pYYJsonWrapper.release(), &pSec, nullptr, &err);
+
+	if (!batchHandle)
+	{
+		smutils->LogError(myself, "Could not create JSON handle (error %d)", err);
+		return;
+	}
+
+	m_server->pBatchForward->PushCell(m_server->m_webSocketServer_handle);
+	m_server->pBatchForward->PushCell(batchHandle);
+	m_server->pBatchForward->PushCell(count);
+	m_server->pBatchForward->Execute(nullptr);
+
+	handlesys->FreeHandle(batchHandle, &pSec);
+}
+
+void WsServerOpenTaskContext::OnCompleted()
+{
+	const std::string& remoteAddress = WebSocketServer::GetRemoteAddress(m_connectionState);
 	m_server->pOpenForward->PushCell(m_server->m_webSocketServer_handle);
 	m_server->pOpenForward->PushString(remoteAddress.c_str());
 	m_server->pOpenForward->PushString(m_connectionState->getId().c_str());
+	m_server->pOpenForward->PushCell(WebSocketServer::GetConnection(m_connectionState));
 	m_server->pOpenForward->Execute(nullptr);
 }
 
 void WsServerCloseTaskContext::OnCompleted()
 {
+	m_server->ReleaseConnectionClient(m_connectionState);
+
+	if (!m_server->pCloseForward || !m_server->pCloseForward->GetFunctionCount())
 	{
-		std::lock_guard<std::mutex> lock(m_server->m_headersMutex);
-		m_server->m_connectionHeaders.erase(m_connectionState->getId());
+		return;
 	}
 
-	std::string remoteAddress = WebSocketServer::GetRemoteAddress(m_connectionState);
+	const std::string& remoteAddress = WebSocketServer::GetRemoteAddress(m_connectionState);
 	m_server->pCloseForward->PushCell(m_server->m_webSocketServer_handle);
 	m_server->pCloseForward->PushCell(m_closeInfo.code);
 	m_server->pCloseForward->PushString(m_closeInfo.reason.c_str());
 	m_server->pCloseForward->PushString(remoteAddress.c_str());
 	m_server->pCloseForward->PushString(m_connectionState->getId().c_str());
+	m_server->pCloseForward->PushCell(WebSocketServer::GetConnection(m_connectionState));
 	m_server->pCloseForward->Execute(nullptr);
 }
 
 void WsServerErrorTaskContext::OnCompleted()
 {
+	m_server->ReleaseConnectionClient(m_connectionState);
+
+	if (!m_server->pErrorForward || !m_server->pErrorForward->GetFunctionCount())
 	{
-		std::lock_guard<std::mutex> lock(m_server->m_headersMutex);
-		auto it = m_server->m_connectionHeaders.find(m_connectionState->getId());
-		if (it != m_server->m_connectionHeaders.end()) {
-			m_server->m_connectionHeaders.erase(it);
-		}
+		return;
 	}
 
-	std::string remoteAddress = WebSocketServer::GetRemoteAddress(m_connectionState);
+	const std::string& remoteAddress = WebSocketServer::GetRemoteAddress(m_connectionState);
 	m_server->pErrorForward->PushCell(m_server->m_webSocketServer_handle);
 	m_server->pErrorForward->PushString(m_errorInfo.reason.c_str());
 	m_server->pErrorForward->PushString(remoteAddress.c_str());
 	m_server->pErrorForward->PushString(m_connectionState->getId().c_str());
+	m_server->pErrorForward->PushCell(WebSocketServer::GetConnection(m_connectionState));
 	m_server->pErrorForward->Execute(nullptr);
 }
\ No newline at end of file
@@ -1,54 +1,150 @@
 #include "extension.h"
 
-class WebSocketServer
+/**
+ * @brief Connection state of a server client, with what the callbacks push for it
+ * worked out once per connection.
+ */
+class ServerConnectionState : public ix::ConnectionState
+{
+public:
+	// set by the connection callback, before any event of the connection
+	std::string m_remoteAddress;
+
+	// slot and generation plugins address the client by, -1 until it is open
+	std::atomic<int> m_connection{-1};
+};
+
+class WebSocketServer : public TaskSource
 {
 public:
 	WebSocketServer(const std::string& host, int port, int addressFamily, int pingInterval);
 	~WebSocketServer();
 
+	virtual Handle_t GetSourceHandle() override { return m_webSocketServer_handle; }
+
 public:
-	void OnMessage(const std::string &message, std::shared_ptr<ix::ConnectionState> connectionState, ix::WebSocket* client);
-	void OnOpen(ix::WebSocketOpenInfo openInfo, std::shared_ptr<ix::ConnectionState> connectionState);
+	void OnMessage(std::string &&message, std::shared_ptr<ix::ConnectionState> connectionState, const std::weak_ptr<ix::WebSocket>& client);
+	void OnBinaryMessage(std::string &&message, std::shared_ptr<ix::ConnectionState> connectionState, const std::weak_ptr<ix::WebSocket>& client);
+	void OnOpen(ix::WebSocketOpenInfo openInfo, std::shared_ptr<ix::ConnectionState> connectionState, std::weak_ptr<ix::WebSocket> client);
 	void OnClose(ix::WebSocketCloseInfo closeInfo, std::shared_ptr<ix::ConnectionState> connectionState);
 	void OnError(ix::WebSocketErrorInfo errorInfo, std::shared_ptr<ix::ConnectionState> connectionState);
 	void broadcastMessage(const std::string& message);
+	void broadcastBinary(const char* data, size_t length);
+	void broadcastPrepared(const ix::WebSocketPreparedMessage& message);
 	bool sendToClient(const std::string& clientId, const std::string& message);
+	bool sendBinaryToClient(const std::string& clientId, const char* data, size_t length);
 	bool disconnectClient(const std::string& clientId);
 	std::vector<std::string> getClientIds();
+	bool getClientId(size_t index, std::string& outId);
+	size_t getClientCount();
 	bool getClientHeaders(const std::string& clientId, ix::WebSocketHttpHeaders& outHeaders);
+	bool getClientHeader(const std::string& clientId, const std::string& key, std::string& outValue);
+	bool sendToConnection(int connection, const std::string& message);
+	bool sendBinaryToConnection(int connection, const char* data, size_t length);
+	bool disconnectConnection(int connection);
+	bool getConnectionClientId(int connection, std::string& outId);
+	int getClientConnection(const std::string& clientId);
+	bool joinRoom(const std::string& clientId, const std::string& room);
+	bool leaveRoom(const std::string& clientId, const std::string& room);
+	size_t publishToRoom(const std::string& room, const std::string& message);
+	size_t publishBinaryToRoom(const std::string& room, const char* data, size_t length);
+	size_t getRoomSize(const std::string& room);
 	
 	ix::WebSocketServer m_webSocketServer;
 	Handle_t m_webSocketServer_handle = BAD_HANDLE;
 
-	std::mutex m_headersMutex;
-	std::unordered_map<std::string, ix::WebSocketHttpHeaders> m_connectionHeaders;
+	MessageBatch m_batch;
+	MessageFilter m_filter;
 
 	IChangeableForward *pMessageForward = nullptr;
+	IChangeableForward *pBatchForward = nullptr;
+	IChangeableForward *pBinaryForward = nullptr;
 	IChangeableForward *pOpenForward = nullptr;
 	IChangeableForward *pCloseForward = nullptr;
 	IChangeableForward *pErrorForward = nullptr;
 
-	std::shared_ptr<ix::WebSocket> GetClientById(const std::string& clientId)
-	{
-		for (const auto& [websocket, id] : m_webSocketServer.getClients())
-		{
-			if (id == clientId) return websocket;
-		}
-		
-		return nullptr;
+	/**
+	 * @brief Finds an open connection, without going through the ix client list.
+	 */
+	std::shared_ptr<ix::WebSocket> GetClientById(const std::string& clientId);
+
+	/**
+	 * @brief Finds an open connection by slot, a stale generation finds nothing.
+	 */
+	std::shared_ptr<ix::WebSocket> GetClientByConnection(int connection);
+
+	/**
+	 * @return The connection id, (generation << 16) | slot.
+	 */
+	int AddClient(const std::string& clientId, std::weak_ptr<ix::WebSocket> client, const ix::WebSocketHttpHeaders& headers);
+	void RemoveClient(const std::string& clientId);
+
+	/**
+	 * @brief Client object passed to the message callback, made on the first message
+	 * of a connection and kept until its close or error callback. Game thread only.
+	 *
+	 * @return nullptr if the handle could not be created.
+	 */
+	WebSocketClient* GetConnectionClient(const std::shared_ptr<ix::ConnectionState>& connectionState, std::shared_ptr<ix::WebSocket> client);
+	void ReleaseConnectionClient(const std::shared_ptr<ix::ConnectionState>& connectionState);
+
+	// the server makes every connection state through its factory
+	static const std::string& GetRemoteAddress(const std::shared_ptr<ix::ConnectionState>& connectionState) {
+		return static_cast<ServerConnectionState*>(connectionState.get())->m_remoteAddress;
 	}
 
-	static std::string GetRemoteAddress(const std::shared_ptr<ix::ConnectionState>& connectionState) {
-		return connectionState->getRemoteIp() + ":" + std::to_string(connectionState->getRemotePort());
+	static int GetConnection(const std::shared_ptr<ix::ConnectionState>& connectionState) {
+		return static_cast<ServerConnectionState*>(connectionState.get())->m_connection.load(std::memory_order_relaxed);
 	}
+
+	static const int kMaxSlots = 1 << 16;
+
+private:
+	// open connections by id, kept by the network threads on open and close
+	struct ClientEntry
+	{
+		std::weak_ptr<ix::WebSocket> socket;
+		ix::WebSocketHttpHeaders headers;
+		size_t position;
+		int connection;
+		std::unordered_set<std::string> rooms;
+	};
+
+	// open connections by slot, a slot is reused with the next generation once its client leaves
+	struct Slot
+	{
+		std::weak_ptr<ix::WebSocket> socket;
+		std::string clientId;
+		int generation = 1;
+		bool used = false;
+	};
+
+	std::mutex m_clientsMutex;
+	std::unordered_map<std::string, ClientEntry> m_clients;
+	// ids in no particular order, for access by index
+	std::vector<std::string> m_clientIds;
+	// client ids by room, a room goes away with its last member
+	std::unordered_map<std::string, std::unordered_set<std::string>> m_rooms;
+	std::vector<Slot> m_slots;
+	std::vector<int> m_freeSlots;
+
+	Slot* FindSlot(int connection);
+
+	// client objects handed to plugins by connection, only touched by the game thread
+	std::unordered_map<ix::ConnectionState*, WebSocketClient*> m_connectionClients;
+
+	// the sockets to broadcast to, sends happen outside the lock
+	std::vector<std::shared_ptr<ix::WebSocket>> GetClientSockets();
+	std::vector<std::shared_ptr<ix::WebSocket>> GetRoomSockets(const std::string& room);
+	size_t publishPrepared(const std::string& room, const ix::WebSocketPreparedMessage& message);
 };
 
-class WsServerMessageTaskContext : public ITaskContext
+class WsServerMessageTaskContext : public SourceTaskContext<WsServerMessageTaskContext>
 {
 public:
-	WsServerMessageTaskContext(WebSocketServer* server, const std::string& message, 
-		std::shared_ptr<ix::ConnectionState> connectionState, ix::WebSocket* client) 
-		: m_server(server), m_message(message), m_connectionState(connectionState), m_client(client) {}
+	WsServerMessageTaskContext(WebSocketServer* server, std::string&& message, 
+		std::shared_ptr<ix::ConnectionState> connectionState, std::shared_ptr<ix::WebSocket> client, uint64_t seq) 
+		: SourceTaskContext(server), m_server(server), m_message(std::move(message)), m_connectionState(connectionState), m_client(std::move(client)), m_seq(seq) {}
 	
 	virtual void OnCompleted() override;
 	
@@ -56,15 +152,44 @@ private:
 	WebSocketServer* m_server;
 	std::string m_message;
 	std::shared_ptr<ix::ConnectionState> m_connectionState;
-	ix::WebSocket* m_client;
+	std::shared_ptr<ix::WebSocket> m_client;
+	uint64_t m_seq;
+};
+
+class WsServerBinaryTaskContext : public SourceTaskContext<WsServerBinaryTaskContext>
+{
+public:
+	WsServerBinaryTaskContext(WebSocketServer* server, std::string&& message, 
+		std::shared_ptr<ix::ConnectionState> connectionState, uint64_t seq) 
+		: SourceTaskContext(server), m_server(server), m_message(std::move(message)), m_connectionState(connectionState), m_seq(seq) {}
+	
+	virtual void OnCompleted() override;
+	
+private:
+	WebSocketServer* m_server;
+	std::string m_message;
+	std::shared_ptr<ix::ConnectionState> m_connectionState;
+	uint64_t m_seq;
+};
+
+class WsServerBatchTaskContext : public SourceTaskContext<WsServerBatchTaskContext>
+{
+public:
+	WsServerBatchTaskContext(WebSocketServer* server) 
+		: SourceTaskContext(server), m_server(server) {}
+	
+	virtual void OnCompleted() override;
+	
+private:
+	WebSocketServer* m_server;
 };
 
-class WsServerOpenTaskContext : public ITaskContext
+class WsServerOpenTaskContext : public SourceTaskContext<WsServerOpenTaskContext>
 {
 public:
 	WsServerOpenTaskContext(WebSocketServer* server, ix::WebSocketOpenInfo openInfo, 
 		std::shared_ptr<ix::ConnectionState> connectionState) 
-		: m_server(server), m_openInfo(openInfo), m_connectionState(connectionState) {}
+		: SourceTaskContext(server), m_server(server), m_openInfo(openInfo), m_connectionState(connectionState) {}
 	
 	virtual void OnCompleted() override;
 	
@@ -74,12 +199,12 @@ private:
 	std::shared_ptr<ix::ConnectionState> m_connectionState;
 };
 
-class WsServerCloseTaskContext : public ITaskContext
+class WsServerCloseTaskContext : public SourceTaskContext<WsServerCloseTaskContext>
 {
 public:
 	WsServerCloseTaskContext(WebSocketServer* server, ix::WebSocketCloseInfo closeInfo, 
 		std::shared_ptr<ix::ConnectionState> connectionState) 
-		: m_server(server), m_closeInfo(closeInfo), m_connectionState(connectionState) {}
+		: SourceTaskContext(server), m_server(server), m_closeInfo(closeInfo), m_connectionState(connectionState) {}
 	
 	virtual void OnCompleted() override;
 	
@@ -89,12 +214,12 @@ private:
 	std::shared_ptr<ix::ConnectionState> m_connectionState;
 };
 
-class WsServerErrorTaskContext : public ITaskContext
+class WsServerErrorTaskContext : public SourceTaskContext<WsServerErrorTaskContext>
 {
 public:
 	WsServerErrorTaskContext(WebSocketServer* server, ix::WebSocketErrorInfo errorInfo, 
 		std::shared_ptr<ix::ConnectionState> connectionState) 
-		: m_server(server), m_errorInfo(errorInfo), m_connectionState(connectionState) {}
+		: SourceTaskContext(server), m_server(server), m_errorInfo(errorInfo), m_connectionState(connectionState) {}
 	
 	virtual void OnCompleted() override;
 	
@@ -57,6 +57,13 @@ public:
 	bool m_iterInitialized{ false };
 };
 
+struct YYJsonDocDeleter {
+	void operator()(yyjson_doc* doc) const { yyjson_doc_free(doc); }
+};
+
+// owns a document until it is handed to a YYJsonWrapper
+using YYJsonDocPtr = std::unique_ptr<yyjson_doc, YYJsonDocDeleter>;
+
 // Helper functions
 inline std::unique_ptr<YYJsonWrapper> CreateWrapper() {
 	return std::make_unique<YYJsonWrapper>();
@@ -45,6 +45,18 @@ namespace ix
 {
     const int64_t DNSLookup::kDefaultWait = 1; // ms
 
+    std::atomic<DNSLookup::Cache*> DNSLookup::_cache(nullptr);
+
+    void DNSLookup::setCache(Cache* cache)
+    {
+        _cache = cache;
+    }
+
+    DNSLookup::Cache* DNSLookup::getCache()
+    {
+        return _cache;
+    }
+
     DNSLookup::DNSLookup(const std::string& hostname, int port, int64_t wait)
         : _hostname(hostname)
         , _port(port)
@@ -74,13 +86,30 @@ namespace ix
             errMsg = gai_strerror(getaddrinfo_result);
             res = nullptr;
         }
-        return AddrInfoPtr{ res, freeaddrinfo };
+        AddrInfoPtr result{ res, freeaddrinfo };
+
+        // Also from a background thread whose lookup was cancelled, the answer is still good
+        if (Cache* cache = _cache)
+        {
+            cache->store(hostname, port, result, errMsg);
+        }
+
+        return result;
     }
 
     DNSLookup::AddrInfoPtr DNSLookup::resolve(std::string& errMsg,
                                         const CancellationRequest& isCancellationRequested,
                                         bool cancellable)
     {
+        if (Cache* cache = _cache)
+        {
+            AddrInfoPtr res;
+            if (cache->lookup(_hostname, _port, res, errMsg))
+            {
+                return res;
+            }
+        }
+
         return cancellable ? resolveCancellable(errMsg, isCancellationRequested)
                            : resolveUnCancellable(errMsg, isCancellationRequested);
     }
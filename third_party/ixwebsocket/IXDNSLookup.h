@@ -26,6 +26,30 @@ namespace ix
     {
     public:
         using AddrInfoPtr = std::shared_ptr<addrinfo>;
+
+        // Process wide cache consulted before each lookup and fed with every result.
+        // Methods are called from any thread, results are never modified once stored.
+        class Cache
+        {
+        public:
+            virtual ~Cache() = default;
+
+            // Returns true on a hit, with res set, or null and errMsg set for a cached failure
+            virtual bool lookup(const std::string& hostname,
+                                int port,
+                                AddrInfoPtr& res,
+                                std::string& errMsg) = 0;
+            virtual void store(const std::string& hostname,
+                               int port,
+                               const AddrInfoPtr& res,
+                               const std::string& errMsg) = 0;
+            // None of the cached addresses could be connected to
+            virtual void invalidate(const std::string& hostname, int port) = 0;
+        };
+
+        static void setCache(Cache* cache);
+        static Cache* getCache();
+
         DNSLookup(const std::string& hostname, int port, int64_t wait = DNSLookup::kDefaultWait);
         ~DNSLookup() = default;
 
@@ -56,6 +80,8 @@ namespace ix
         int64_t _wait;
         const static int64_t kDefaultWait;
 
+        static std::atomic<Cache*> _cache;
+
         AddrInfoPtr _res;
         std::mutex _resMutex;
 
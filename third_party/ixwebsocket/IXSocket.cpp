@@ -207,6 +207,16 @@ namespace ix
         return _selectInterrupt->getFd() != -1 || _selectInterrupt->getEvent() != nullptr;
     }
 
+    int Socket::getFd() const
+    {
+        return _sockfd;
+    }
+
+    int Socket::getWakeUpFd() const
+    {
+        return _selectInterrupt->getFd();
+    }
+
     bool Socket::accept(std::string& errMsg)
     {
         if (_sockfd == -1)
@@ -217,6 +227,21 @@ namespace ix
         return true;
     }
 
+    bool Socket::beginAccept(std::string& errMsg)
+    {
+        return accept(errMsg);
+    }
+
+    AcceptResult Socket::acceptStep(std::string& /*errMsg*/)
+    {
+        return AcceptResult::Done;
+    }
+
+    bool Socket::hasBufferedData()
+    {
+        return false;
+    }
+
     bool Socket::connect(const std::string& host,
                          int port,
                          std::string& errMsg,
@@ -40,6 +40,14 @@ namespace ix
         CloseRequest = 5
     };
 
+    enum class AcceptResult
+    {
+        Done = 0,
+        WantRead = 1,
+        WantWrite = 2,
+        Failed = 3
+    };
+
     class Socket
     {
     public:
@@ -55,9 +63,21 @@ namespace ix
         PollResultType isReadyToWrite(int timeoutMs);
         PollResultType isReadyToRead(int timeoutMs);
 
+        // Descriptors an external event loop has to watch, -1 when unavailable
+        int getFd() const;
+        int getWakeUpFd() const;
+
         // Virtual methods
         virtual bool accept(std::string& errMsg);
 
+        // Server side handshake for event loops, beginAccept prepares it without blocking
+        // and acceptStep advances it each time the descriptor is ready. The default runs
+        // accept() in beginAccept, for transports that cannot do it step by step.
+        virtual bool beginAccept(std::string& errMsg);
+        virtual AcceptResult acceptStep(std::string& errMsg);
+        // Whether received data is buffered where polling the descriptor cannot see it
+        virtual bool hasBufferedData();
+
         virtual bool connect(const std::string& host,
                              int port,
                              std::string& errMsg,
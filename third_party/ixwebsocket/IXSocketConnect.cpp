@@ -124,6 +124,15 @@ namespace ix
             }
         }
 
+        // The addresses may have come from the cache and be stale
+        if (sockfd == -1 && !isCancellationRequested())
+        {
+            if (DNSLookup::Cache* cache = DNSLookup::getCache())
+            {
+                cache->invalidate(hostname, port);
+            }
+        }
+
         return sockfd;
     }
 
@@ -10,9 +10,12 @@
 #include "IXSocketOpenSSL.h"
 
 #include "IXSocketConnect.h"
+#include "IXTLSSessionCache.h"
 #include "IXUniquePtr.h"
 #include <cassert>
 #include <errno.h>
+#include <list>
+#include <unordered_map>
 #include <vector>
 #ifdef _WIN32
 #include <shlwapi.h>
@@ -81,8 +84,157 @@ namespace
 } // namespace
 #endif
 
+namespace
+{
+    class TLSSessionCache
+    {
+    public:
+        ~TLSSessionCache()
+        {
+            clear();
+        }
+
+        // Returns a new reference, to be released with SSL_SESSION_free
+        SSL_SESSION* get(const std::string& key)
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+
+            auto it = _index.find(key);
+            if (it == _index.end())
+            {
+                return nullptr;
+            }
+
+            _sessions.splice(_sessions.begin(), _sessions, it->second);
+            SSL_SESSION* session = it->second->second;
+#if OPENSSL_VERSION_NUMBER >= 0x10100000L
+            SSL_SESSION_up_ref(session);
+#else
+            CRYPTO_add(&session->references, 1, CRYPTO_LOCK_SSL_SESSION);
+#endif
+            return session;
+        }
+
+        // Takes over the reference
+        void put(const std::string& key, SSL_SESSION* session)
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+
+            if (_maxSize == 0)
+            {
+                SSL_SESSION_free(session);
+                return;
+            }
+
+            eraseLocked(key);
+
+            _sessions.emplace_front(key, session);
+            _index[key] = _sessions.begin();
+
+            while (_sessions.size() > _maxSize)
+            {
+                eraseLocked(_sessions.back().first);
+            }
+        }
+
+        void erase(const std::string& key)
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            eraseLocked(key);
+        }
+
+        void clear()
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            for (auto& entry : _sessions)
+            {
+                SSL_SESSION_free(entry.second);
+            }
+            _sessions.clear();
+            _index.clear();
+        }
+
+        void setMaxSize(size_t maxSize)
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _maxSize = maxSize;
+            while (_sessions.size() > _maxSize)
+            {
+                eraseLocked(_sessions.back().first);
+            }
+        }
+
+        size_t getMaxSize()
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            return _maxSize;
+        }
+
+        size_t size()
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            return _sessions.size();
+        }
+
+        std::atomic<uint64_t> hits{0};
+        std::atomic<uint64_t> misses{0};
+
+    private:
+        void eraseLocked(const std::string& key)
+        {
+            auto it = _index.find(key);
+            if (it == _index.end())
+            {
+                return;
+            }
+
+            SSL_SESSION_free(it->second->second);
+            _sessions.erase(it->second);
+            _index.erase(it);
+        }
+
+        std::mutex _mutex;
+        size_t _maxSize = 64;
+        std::list<std::pair<std::string, SSL_SESSION*>> _sessions;
+        std::unordered_map<std::string, std::list<std::pair<std::string, SSL_SESSION*>>::iterator>
+            _index;
+    };
+
+    TLSSessionCache& tlsSessionCache()
+    {
+        static TLSSessionCache cache;
+        return cache;
+    }
+} // namespace
+
 namespace ix
 {
+    void setTLSSessionCacheSize(size_t maxSessions)
+    {
+        tlsSessionCache().setMaxSize(maxSessions);
+    }
+
+    size_t getTLSSessionCacheSize()
+    {
+        return tlsSessionCache().getMaxSize();
+    }
+
+    void clearTLSSessionCache()
+    {
+        tlsSessionCache().clear();
+    }
+
+    TLSSessionCacheStats getTLSSessionCacheStats()
+    {
+        TLSSessionCache& cache = tlsSessionCache();
+
+        TLSSessionCacheStats stats;
+        stats.hits = cache.hits;
+        stats.misses = cache.misses;
+        stats.size = cache.size();
+        return stats;
+    }
+
     const std::string kDefaultCiphers =
         "ECDHE-ECDSA-AES128-GCM-SHA256 ECDHE-ECDSA-AES256-GCM-SHA384 ECDHE-ECDSA-AES128-SHA "
         "ECDHE-ECDSA-AES256-SHA ECDHE-ECDSA-AES128-SHA256 ECDHE-ECDSA-AES256-SHA384 "
@@ -569,6 +721,23 @@ namespace ix
     bool SocketOpenSSL::accept(std::string& errMsg)
     {
         bool handshakeSuccessful = false;
+        if (beginAccept(errMsg))
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            handshakeSuccessful = openSSLServerHandshake(errMsg);
+        }
+
+        if (!handshakeSuccessful)
+        {
+            close();
+            return false;
+        }
+
+        return true;
+    }
+
+    bool SocketOpenSSL::beginAccept(std::string& errMsg)
+    {
         {
             std::lock_guard<std::mutex> lock(_mutex);
 
@@ -710,17 +879,55 @@ namespace ix
             SSL_set_ecdh_auto(_ssl_connection, 1);
 
             SSL_set_fd(_ssl_connection, _sockfd);
+        }
 
-            handshakeSuccessful = openSSLServerHandshake(errMsg);
+        return true;
+    }
+
+    AcceptResult SocketOpenSSL::acceptStep(std::string& errMsg)
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+
+        if (_ssl_connection == nullptr)
+        {
+            return AcceptResult::Failed;
         }
 
-        if (!handshakeSuccessful)
+        ERR_clear_error();
+        int accept_result = SSL_accept(_ssl_connection);
+        if (accept_result == 1)
+        {
+            return AcceptResult::Done;
+        }
+
+        int reason = SSL_get_error(_ssl_connection, accept_result);
+        if (reason == SSL_ERROR_WANT_READ)
+        {
+            return AcceptResult::WantRead;
+        }
+        if (reason == SSL_ERROR_WANT_WRITE)
+        {
+            return AcceptResult::WantWrite;
+        }
+
+        errMsg = getSSLError(accept_result);
+        return AcceptResult::Failed;
+    }
+
+    bool SocketOpenSSL::hasBufferedData()
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+
+        if (_ssl_connection == nullptr)
         {
-            close();
             return false;
         }
 
-        return true;
+#if OPENSSL_VERSION_NUMBER >= 0x10100000L
+        return SSL_has_pending(_ssl_connection) != 0;
+#else
+        return SSL_pending(_ssl_connection) > 0;
+#endif
     }
 
     bool SocketOpenSSL::connect(const std::string& host,
@@ -752,6 +959,13 @@ namespace ix
                 return false;
             }
 
+            // sessions are handed to the callback whenever the server issues one, instead of
+            // being read once after the handshake, before a TLS 1.3 ticket has arrived
+            SSL_CTX_set_session_cache_mode(_ssl_context,
+                                           SSL_SESS_CACHE_CLIENT |
+                                               SSL_SESS_CACHE_NO_INTERNAL_STORE);
+            SSL_CTX_sess_set_new_cb(_ssl_context, openSSLNewSessionCallback);
+
             _ssl_connection = SSL_new(_ssl_context);
             if (_ssl_connection == nullptr)
             {
@@ -761,10 +975,24 @@ namespace ix
                 return false;
             }
             SSL_set_fd(_ssl_connection, _sockfd);
+            SSL_set_app_data(_ssl_connection, this);
 
             // SNI support
             SSL_set_tlsext_host_name(_ssl_connection, host.c_str());
 
+            // Everything that decides whether the server is trusted is part of the key,
+            // resuming skips the certificate checks
+            _sessionKey = host + ":" + std::to_string(port) + "|" + _tlsOptions.caFile + "|" +
+                         _tlsOptions.certFile + "|" + _tlsOptions.keyFile + "|" +
+                         _tlsOptions.ciphers + "|" +
+                         (_tlsOptions.disable_hostname_validation ? "novalidate" : "validate");
+
+            if (SSL_SESSION* session = tlsSessionCache().get(_sessionKey))
+            {
+                SSL_set_session(_ssl_connection, session);
+                SSL_SESSION_free(session);
+            }
+
 #if OPENSSL_VERSION_NUMBER >= 0x10002000L
             // Support for server name verification
             // (The docs say that this should work from 1.0.2, and is the default from
@@ -777,6 +1005,25 @@ namespace ix
             }
 #endif
             handshakeSuccessful = openSSLClientHandshake(host, errMsg, isCancellationRequested);
+
+            if (handshakeSuccessful)
+            {
+                TLSSessionCache& cache = tlsSessionCache();
+
+                if (SSL_session_reused(_ssl_connection))
+                {
+                    cache.hits++;
+                }
+                else
+                {
+                    cache.misses++;
+                }
+            }
+            else
+            {
+                // don't try the same session again if it is why the handshake failed
+                tlsSessionCache().erase(_sessionKey);
+            }
         }
 
         if (!handshakeSuccessful)
@@ -788,12 +1035,29 @@ namespace ix
         return true;
     }
 
+    int SocketOpenSSL::openSSLNewSessionCallback(SSL* ssl, SSL_SESSION* session)
+    {
+        // called from within SSL_connect or SSL_read, under the socket mutex, on resumed
+        // connections too, so the ticket kept is always the newest one
+        auto socket = static_cast<SocketOpenSSL*>(SSL_get_app_data(ssl));
+        if (socket == nullptr)
+        {
+            return 0;
+        }
+
+        tlsSessionCache().put(socket->_sessionKey, session);
+        return 1; // the cache took over the reference
+    }
+
     void SocketOpenSSL::close()
     {
         std::lock_guard<std::mutex> lock(_mutex);
 
         if (_ssl_connection != nullptr)
         {
+            // Freeing a connection that was not shut down makes its session non resumable,
+            // mark it as shut down without writing to a socket that may be gone already
+            SSL_set_shutdown(_ssl_connection, SSL_SENT_SHUTDOWN | SSL_RECEIVED_SHUTDOWN);
             SSL_free(_ssl_connection);
             _ssl_connection = nullptr;
         }
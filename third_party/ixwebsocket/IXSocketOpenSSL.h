@@ -26,6 +26,9 @@ namespace ix
         ~SocketOpenSSL();
 
         virtual bool accept(std::string& errMsg) final;
+        virtual bool beginAccept(std::string& errMsg) final;
+        virtual AcceptResult acceptStep(std::string& errMsg) final;
+        virtual bool hasBufferedData() final;
 
         virtual bool connect(const std::string& host,
                              int port,
@@ -48,6 +51,8 @@ namespace ix
         bool checkHost(const std::string& host, const char* pattern);
         bool handleTLSOptions(std::string& errMsg);
         bool openSSLServerHandshake(std::string& errMsg);
+        // Stores tickets as they arrive, under TLS 1.3 that is after the handshake
+        static int openSSLNewSessionCallback(SSL* ssl, SSL_SESSION* session);
 
         // Required for OpenSSL < 1.1
         static void openSSLLockingCallback(int mode, int type, const char* /*file*/, int /*line*/);
@@ -56,6 +61,7 @@ namespace ix
         SSL_CTX* _ssl_context;
         const SSL_METHOD* _ssl_method;
         SocketTLSOptions _tlsOptions;
+        std::string _sessionKey;
 
         mutable std::mutex _mutex; // OpenSSL routines are not thread-safe
 
@@ -34,6 +34,7 @@ namespace ix
         , _maxConnections(maxConnections)
         , _addressFamily(addressFamily)
         , _serverFd(-1)
+        , _listening(false)
         , _stop(false)
         , _stopGc(false)
         , _connectionStateFactory(&ConnectionState::createConnectionState)
@@ -170,6 +171,7 @@ namespace ix
             return std::make_pair(false, ss.str());
         }
 
+        _listening = true;
         return std::make_pair(true, "");
     }
 
@@ -230,6 +232,7 @@ namespace ix
 
         _conditionVariable.notify_one();
         Socket::closeSocket(_serverFd);
+        _listening = false;
     }
 
     void SocketServer::setConnectionStateFactory(
@@ -408,22 +411,30 @@ namespace ix
             // Set the socket to non blocking mode + other tweaks
             SocketConnect::configure(clientFd);
 
-            if (!socket->accept(errorMsg))
+            // a deferred handshake must not wait on the client here, it would stall every accept
+            bool accepted =
+                isAcceptDeferred() ? socket->beginAccept(errorMsg) : socket->accept(errorMsg);
+            if (!accepted)
             {
                 logError("SocketServer::run() tls accept failed: " + errorMsg);
                 Socket::closeSocket(clientFd);
                 continue;
             }
 
-            // Launch the handleConnection work asynchronously in its own thread.
-            std::lock_guard<std::mutex> lock(_connectionsThreadsMutex);
-            _connectionsThreads.push_back(std::make_pair(
-                connectionState,
-                std::thread(
-                    &SocketServer::handleConnection, this, std::move(socket), connectionState)));
+            dispatchConnection(std::move(socket), connectionState);
         }
     }
 
+    void SocketServer::dispatchConnection(std::unique_ptr<Socket> socket,
+                                          std::shared_ptr<ConnectionState> connectionState)
+    {
+        // Launch the handleConnection work asynchronously in its own thread.
+        std::lock_guard<std::mutex> lock(_connectionsThreadsMutex);
+        _connectionsThreads.push_back(std::make_pair(
+            connectionState,
+            std::thread(&SocketServer::handleConnection, this, std::move(socket), connectionState)));
+    }
+
     size_t SocketServer::getConnectionsThreadsCount()
     {
         std::lock_guard<std::mutex> lock(_connectionsThreadsMutex);
@@ -499,6 +510,20 @@ namespace ix
         return _maxConnections;
     }
 
+    bool SocketServer::setMaxConnections(std::size_t maxConnections)
+    {
+        // the accept thread reads it unsynchronized
+        if (_listening) return false;
+
+        _maxConnections = maxConnections;
+        return true;
+    }
+
+    bool SocketServer::isListening() const
+    {
+        return _listening;
+    }
+
     int SocketServer::getAddressFamily()
     {
         return _addressFamily;
@@ -64,6 +64,9 @@ namespace ix
         std::string getHost();
         int getBacklog();
         std::size_t getMaxConnections();
+        // Refused once listen() succeeded, until stop()
+        bool setMaxConnections(std::size_t maxConnections);
+        bool isListening() const;
         int getAddressFamily();
     protected:
         // Logging
@@ -71,6 +74,20 @@ namespace ix
         void logInfo(const std::string& str);
 
         void stopAcceptingConnections();
+        bool isTLSEnabled() const
+        {
+            return _socketTLSOptions.tls;
+        }
+
+        // Whether dispatchConnection finishes the TLS handshake, the accept thread only begins it
+        virtual bool isAcceptDeferred() const
+        {
+            return false;
+        }
+
+        // Called on the accept thread, the default runs handleConnection on a thread of its own
+        virtual void dispatchConnection(std::unique_ptr<Socket> socket,
+                                        std::shared_ptr<ConnectionState> connectionState);
 
     private:
         // Member variables
@@ -82,6 +99,7 @@ namespace ix
 
         // socket for accepting connections
         socket_t _serverFd;
+        std::atomic<bool> _listening;
 
         std::atomic<bool> _stop;
 
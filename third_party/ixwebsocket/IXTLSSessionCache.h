@@ -0,0 +1,33 @@
+/*
+ *  IXTLSSessionCache.h
+ *
+ *  Process wide cache of TLS client sessions, so that reconnecting to the
+ *  same server resumes the previous session instead of doing a full
+ *  handshake. Shared by every WebSocket and HTTP client connection.
+ *
+ *  Sessions are keyed by host, port and the TLS options that affect
+ *  verification, so a session is never resumed by a connection with
+ *  stricter settings than the one that established it.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace ix
+{
+    struct TLSSessionCacheStats
+    {
+        uint64_t hits = 0;   // handshakes that resumed a cached session
+        uint64_t misses = 0; // full handshakes
+        size_t size = 0;     // cached sessions
+    };
+
+    // Least recently used sessions are dropped beyond maxSessions, 0 disables the cache
+    void setTLSSessionCacheSize(size_t maxSessions);
+    size_t getTLSSessionCacheSize();
+
+    void clearTLSSessionCache();
+    TLSSessionCacheStats getTLSSessionCacheStats();
+} // namespace ix
@@ -11,6 +11,7 @@
 #include "IXUniquePtr.h"
 #include "IXUtf8Validator.h"
 #include "IXWebSocketHandshake.h"
+#include "IXWebSocketReactor.h"
 #include <cassert>
 #include <cmath>
 #include <cstdint>
@@ -42,6 +43,8 @@ namespace ix
         , _pingIntervalSecs(kDefaultPingIntervalSecs)
         , _pingType(SendMessageKind::Ping)
         , _autoThreadName(true)
+        , _reactor(nullptr)
+        , _attachedReactor(nullptr)
     {
         _ws.setOnCloseCallback(
             [this](uint16_t code, const std::string& reason, size_t wireSize, bool remote)
@@ -181,6 +184,21 @@ namespace ix
     {
         if (_thread.joinable()) return; // we've already been started
 
+        // still attached, possibly waiting to reconnect: the loop keeps driving us even if
+        // setReactor changed since, a driver thread next to it would share the transport
+        if (WebSocketReactor* attached = _attachedReactor)
+        {
+            attached->add(this);
+            return;
+        }
+
+        WebSocketReactor* reactor = _reactor;
+        if (reactor && reactor->add(this))
+        {
+            _attachedReactor = reactor;
+            return;
+        }
+
         _thread = std::thread(&WebSocket::run, this);
     }
 
@@ -197,6 +215,14 @@ namespace ix
             _thread.join();
             _stop = false;
         }
+        else if (WebSocketReactor* reactor = _attachedReactor.exchange(nullptr))
+        {
+            // same as above, the reactor lets go of us once the close is finished
+            _stop = true;
+            _sleepCondition.notify_one();
+            reactor->remove(this);
+            _stop = false;
+        }
     }
 
     WebSocketInitResult WebSocket::connect(int timeoutSecs)
@@ -343,30 +369,36 @@ namespace ix
 
             if (!status.success)
             {
-                WebSocketErrorInfo connectErr;
-
-                if (_automaticReconnection)
-                {
-                    duration =
-                        millis(calculateRetryWaitMilliseconds(retries++,
-                                                              _maxWaitBetweenReconnectionRetries,
-                                                              _minWaitBetweenReconnectionRetries));
+                duration = millis(reportConnectionError(status, retries));
+            }
+        }
+    }
 
-                    connectErr.wait_time = duration.count();
-                    connectErr.retries = retries;
-                }
+    double WebSocket::reportConnectionError(const WebSocketInitResult& status, uint32_t& retries)
+    {
+        WebSocketErrorInfo connectErr;
+        double duration = 0;
 
-                connectErr.reason = status.errorStr;
-                connectErr.http_status = status.http_status;
+        if (_automaticReconnection)
+        {
+            duration = calculateRetryWaitMilliseconds(
+                retries++, _maxWaitBetweenReconnectionRetries, _minWaitBetweenReconnectionRetries);
 
-                _onMessageCallback(ix::make_unique<WebSocketMessage>(WebSocketMessageType::Error,
-                                                                     emptyMsg,
-                                                                     0,
-                                                                     connectErr,
-                                                                     WebSocketOpenInfo(),
-                                                                     WebSocketCloseInfo()));
-            }
+            connectErr.wait_time = duration;
+            connectErr.retries = retries;
         }
+
+        connectErr.reason = status.errorStr;
+        connectErr.http_status = status.http_status;
+
+        _onMessageCallback(ix::make_unique<WebSocketMessage>(WebSocketMessageType::Error,
+                                                             emptyMsg,
+                                                             0,
+                                                             connectErr,
+                                                             WebSocketOpenInfo(),
+                                                             WebSocketCloseInfo()));
+
+        return duration;
     }
 
     void WebSocket::run()
@@ -394,62 +426,74 @@ namespace ix
             // We can avoid to poll if we want to stop and are not closing
             if (_stop && !isClosing()) break;
 
-            // 2. Poll to see if there's any new data available
-            WebSocketTransport::PollResult pollResult = _ws.poll();
+            // 2. Poll to see if there's any new data available and dispatch it
+            pollOnce(true);
+        }
+    }
+
+    void WebSocket::pollOnce(bool block)
+    {
+        WebSocketTransport::PollResult pollResult = _ws.poll(block);
 
-            // 3. Dispatch the incoming messages
-            _ws.dispatch(
-                pollResult,
-                [this](const std::string& msg,
-                       size_t wireSize,
-                       bool decompressionError,
-                       WebSocketTransport::MessageKind messageKind)
+        // Dispatch the incoming messages
+        _ws.dispatch(
+            pollResult,
+            [this](std::string& msg,
+                   size_t wireSize,
+                   bool decompressionError,
+                   WebSocketTransport::MessageKind messageKind)
+            {
+                WebSocketMessageType webSocketMessageType {WebSocketMessageType::Error};
+                switch (messageKind)
                 {
-                    WebSocketMessageType webSocketMessageType {WebSocketMessageType::Error};
-                    switch (messageKind)
+                    case WebSocketTransport::MessageKind::MSG_TEXT:
+                    case WebSocketTransport::MessageKind::MSG_BINARY:
                     {
-                        case WebSocketTransport::MessageKind::MSG_TEXT:
-                        case WebSocketTransport::MessageKind::MSG_BINARY:
-                        {
-                            webSocketMessageType = WebSocketMessageType::Message;
-                        }
-                        break;
-
-                        case WebSocketTransport::MessageKind::PING:
-                        {
-                            webSocketMessageType = WebSocketMessageType::Ping;
-                        }
-                        break;
-
-                        case WebSocketTransport::MessageKind::PONG:
-                        {
-                            webSocketMessageType = WebSocketMessageType::Pong;
-                        }
-                        break;
-
-                        case WebSocketTransport::MessageKind::FRAGMENT:
-                        {
-                            webSocketMessageType = WebSocketMessageType::Fragment;
-                        }
-                        break;
+                        webSocketMessageType = WebSocketMessageType::Message;
                     }
+                    break;
 
-                    WebSocketErrorInfo webSocketErrorInfo;
-                    webSocketErrorInfo.decompressionError = decompressionError;
+                    case WebSocketTransport::MessageKind::PING:
+                    {
+                        webSocketMessageType = WebSocketMessageType::Ping;
+                    }
+                    break;
 
-                    bool binary = messageKind == WebSocketTransport::MessageKind::MSG_BINARY;
+                    case WebSocketTransport::MessageKind::PONG:
+                    {
+                        webSocketMessageType = WebSocketMessageType::Pong;
+                    }
+                    break;
 
-                    _onMessageCallback(ix::make_unique<WebSocketMessage>(webSocketMessageType,
-                                                                         msg,
-                                                                         wireSize,
-                                                                         webSocketErrorInfo,
-                                                                         WebSocketOpenInfo(),
-                                                                         WebSocketCloseInfo(),
-                                                                         binary));
+                    case WebSocketTransport::MessageKind::FRAGMENT:
+                    {
+                        webSocketMessageType = WebSocketMessageType::Fragment;
+                    }
+                    break;
+                }
 
-                    WebSocket::invokeTrafficTrackerCallback(wireSize, true);
-                });
-        }
+                WebSocketErrorInfo webSocketErrorInfo;
+                webSocketErrorInfo.decompressionError = decompressionError;
+
+                bool binary = messageKind == WebSocketTransport::MessageKind::MSG_BINARY;
+
+                auto webSocketMessage = ix::make_unique<WebSocketMessage>(webSocketMessageType,
+                                                                          msg,
+                                                                          wireSize,
+                                                                          webSocketErrorInfo,
+                                                                          WebSocketOpenInfo(),
+                                                                          WebSocketCloseInfo(),
+                                                                          binary);
+
+                if (webSocketMessageType == WebSocketMessageType::Message)
+                {
+                    webSocketMessage->payload = &msg;
+                }
+
+                _onMessageCallback(webSocketMessage);
+
+                WebSocket::invokeTrafficTrackerCallback(wireSize, true);
+            });
     }
 
     void WebSocket::setOnMessageCallback(const OnMessageCallback& callback)
@@ -532,6 +576,18 @@ namespace ix
         return sendMessage(text, pingType);
     }
 
+    WebSocketSendInfo WebSocket::sendPrepared(const WebSocketPreparedMessage& message)
+    {
+        if (!isConnected()) return WebSocketSendInfo(false);
+
+        std::lock_guard<std::mutex> lock(_writeMutex);
+        WebSocketSendInfo webSocketSendInfo = _ws.sendPrepared(message);
+
+        WebSocket::invokeTrafficTrackerCallback(webSocketSendInfo.wireSize, false);
+
+        return webSocketSendInfo;
+    }
+
     WebSocketSendInfo WebSocket::sendMessage(const IXWebSocketSendData& message,
                                              SendMessageKind sendMessageKind,
                                              const OnProgressCallback& onProgressCallback)
@@ -620,6 +676,11 @@ namespace ix
         return _ws.bufferedAmount();
     }
 
+    int WebSocket::getPingRtt() const
+    {
+        return _ws.getPingRtt();
+    }
+
     void WebSocket::addSubProtocol(const std::string& subProtocol)
     {
         std::lock_guard<std::mutex> lock(_configMutex);
@@ -632,6 +693,16 @@ namespace ix
         return _subProtocols;
     }
 
+    void WebSocket::setReactor(WebSocketReactor* reactor)
+    {
+        _reactor = reactor;
+    }
+
+    WebSocketReactor* WebSocket::getReactor() const
+    {
+        return _reactor;
+    }
+
     void WebSocket::setAutoThreadName(bool enabled)
     {
         _autoThreadName = enabled;
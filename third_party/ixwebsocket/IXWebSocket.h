@@ -37,6 +37,8 @@ namespace ix
         Closed = 3
     };
 
+    class WebSocketReactor;
+
     using OnMessageCallback = std::function<void(const WebSocketMessagePtr&)>;
 
     using OnTrafficTrackerCallback = std::function<void(size_t size, bool incoming)>;
@@ -92,6 +94,8 @@ namespace ix
         WebSocketSendInfo sendText(const std::string& text,
                                    const OnProgressCallback& onProgressCallback = nullptr);
         WebSocketSendInfo ping(const std::string& text,SendMessageKind pingType = SendMessageKind::Ping);
+        // does not check for valid UTF-8 characters either, the frame is shared with other sockets
+        WebSocketSendInfo sendPrepared(const WebSocketPreparedMessage& message);
 
         void close(uint16_t code = WebSocketCloseConstants::kNormalClosureCode,
                    const std::string& reason = WebSocketCloseConstants::kNormalClosureMessage);
@@ -109,6 +113,7 @@ namespace ix
         const std::string getPingMessage() const;
         int getPingInterval() const;
         size_t bufferedAmount() const;
+        int getPingRtt() const;
 
         void enableAutomaticReconnection();
         void disableAutomaticReconnection();
@@ -121,6 +126,11 @@ namespace ix
 
         void setAutoThreadName(bool enabled);
 
+        // Drive this socket from a shared event loop instead of a thread of its own.
+        // Takes effect on the next start(), falls back to a thread if unsupported.
+        void setReactor(WebSocketReactor* reactor);
+        WebSocketReactor* getReactor() const;
+
     private:
         WebSocketSendInfo sendMessage(const IXWebSocketSendData& message,
                                       SendMessageKind sendMessageKind,
@@ -129,6 +139,8 @@ namespace ix
         bool isConnected() const;
         bool isClosing() const;
         void checkConnection(bool firstConnectionAttempt);
+        double reportConnectionError(const WebSocketInitResult& status, uint32_t& retries);
+        void pollOnce(bool block);
         static void invokeTrafficTrackerCallback(size_t size, bool incoming);
 
         // Server
@@ -187,6 +199,11 @@ namespace ix
         // enable or disable auto set thread name
         bool _autoThreadName;
 
+        // shared event loop requested by setReactor, and the one start() attached us to
+        std::atomic<WebSocketReactor*> _reactor;
+        std::atomic<WebSocketReactor*> _attachedReactor;
+
         friend class WebSocketServer;
+        friend class WebSocketReactor;
     };
 } // namespace ix
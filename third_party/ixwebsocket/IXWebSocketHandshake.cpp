@@ -235,11 +235,27 @@ namespace ix
             {
                 _enablePerMessageDeflate = false;
             }
-            // Otherwise try to initialize the deflate engine (zlib)
-            else if (!_perMessageDeflate->init(webSocketPerMessageDeflateOptions))
+            else
             {
-                return WebSocketInitResult(
-                    false, 0, "Failed to initialize per message deflate engine");
+                // We may compress with a smaller window or without context takeover
+                // even if the server did not ask for it, but must decompress with
+                // exactly what the server says it uses.
+                WebSocketPerMessageDeflateOptions negotiated(
+                    true,
+                    _perMessageDeflateOptions.getClientNoContextTakeover() ||
+                        webSocketPerMessageDeflateOptions.getClientNoContextTakeover(),
+                    webSocketPerMessageDeflateOptions.getServerNoContextTakeover(),
+                    std::min(_perMessageDeflateOptions.getClientMaxWindowBits(),
+                             webSocketPerMessageDeflateOptions.getClientMaxWindowBits()),
+                    webSocketPerMessageDeflateOptions.getServerMaxWindowBits());
+                negotiated.setCompressionLevel(_perMessageDeflateOptions.getCompressionLevel());
+
+                // Try to initialize the deflate engine (zlib)
+                if (!_perMessageDeflate->init(negotiated, false))
+                {
+                    return WebSocketInitResult(
+                        false, 0, "Failed to initialize per message deflate engine");
+                }
             }
         }
 
@@ -366,17 +382,25 @@ namespace ix
         std::string header = headers["sec-websocket-extensions"];
         WebSocketPerMessageDeflateOptions webSocketPerMessageDeflateOptions(header);
 
-        // If the client has requested that extension,
-        if (webSocketPerMessageDeflateOptions.enabled() && enablePerMessageDeflate)
+        WebSocketPerMessageDeflateOptions negotiated =
+            _perMessageDeflateOptions.negotiate(webSocketPerMessageDeflateOptions);
+
+        // If the client has requested that extension, with parameters we can honor,
+        if (negotiated.enabled() && enablePerMessageDeflate)
         {
             _enablePerMessageDeflate = true;
 
-            if (!_perMessageDeflate->init(webSocketPerMessageDeflateOptions))
+            if (!_perMessageDeflate->init(negotiated, true))
             {
                 return WebSocketInitResult(
                     false, 0, "Failed to initialize per message deflate engine");
             }
-            ss << webSocketPerMessageDeflateOptions.generateHeader();
+            ss << negotiated.generateHeader();
+        }
+        else
+        {
+            // Enabled by default, but nothing may be compressed unless the client offered it
+            _enablePerMessageDeflate = false;
         }
 
         ss << "\r\n";
@@ -25,6 +25,11 @@ namespace ix
         WebSocketCloseInfo closeInfo;
         bool binary;
 
+        // Buffer behind str for Message types, valid during the callback only.
+        // Consumers that keep the payload may move it out instead of copying,
+        // str is left empty. nullptr for other types.
+        std::string* payload = nullptr;
+
         WebSocketMessage(WebSocketMessageType t,
                          const std::string& s,
                          size_t w,
@@ -69,15 +69,24 @@ namespace ix
     }
 
     bool WebSocketPerMessageDeflate::init(
-        const WebSocketPerMessageDeflateOptions& perMessageDeflateOptions)
+        const WebSocketPerMessageDeflateOptions& perMessageDeflateOptions, bool isServer)
     {
         bool clientNoContextTakeover = perMessageDeflateOptions.getClientNoContextTakeover();
+        bool serverNoContextTakeover = perMessageDeflateOptions.getServerNoContextTakeover();
 
-        uint8_t deflateBits = perMessageDeflateOptions.getClientMaxWindowBits();
-        uint8_t inflateBits = perMessageDeflateOptions.getServerMaxWindowBits();
+        uint8_t clientBits = perMessageDeflateOptions.getClientMaxWindowBits();
+        uint8_t serverBits = perMessageDeflateOptions.getServerMaxWindowBits();
 
-        return _compressor->init(deflateBits, clientNoContextTakeover) &&
-               _decompressor->init(inflateBits, clientNoContextTakeover);
+        int compressionLevel = perMessageDeflateOptions.getCompressionLevel();
+
+        if (isServer)
+        {
+            return _compressor->init(serverBits, serverNoContextTakeover, compressionLevel) &&
+                   _decompressor->init(clientBits, clientNoContextTakeover);
+        }
+
+        return _compressor->init(clientBits, clientNoContextTakeover, compressionLevel) &&
+               _decompressor->init(serverBits, serverNoContextTakeover);
     }
 
     bool WebSocketPerMessageDeflate::compress(const IXWebSocketSendData& in, std::string& out)
@@ -90,6 +99,16 @@ namespace ix
         return _compressor->compress(in, out);
     }
 
+    bool WebSocketPerMessageDeflate::getSharedCompressionSettings(uint8_t& windowBits,
+                                                                  int& compressionLevel) const
+    {
+        if (_compressor->hasContextTakeover()) return false;
+
+        windowBits = _compressor->getDeflateBits();
+        compressionLevel = _compressor->getCompressionLevel();
+        return true;
+    }
+
     bool WebSocketPerMessageDeflate::decompress(const std::string& in, std::string& out)
     {
         return _decompressor->decompress(in, out);
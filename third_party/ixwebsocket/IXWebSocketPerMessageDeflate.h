@@ -50,11 +50,17 @@ namespace ix
         WebSocketPerMessageDeflate();
         ~WebSocketPerMessageDeflate();
 
-        bool init(const WebSocketPerMessageDeflateOptions& perMessageDeflateOptions);
+        // The server compresses with the server_* parameters and the client with the client_* ones
+        bool init(const WebSocketPerMessageDeflateOptions& perMessageDeflateOptions,
+                  bool isServer = false);
         bool compress(const IXWebSocketSendData& in, std::string& out);
         bool compress(const std::string& in, std::string& out);
         bool decompress(const std::string& in, std::string& out);
 
+        // Without context takeover every message is compressed on its own, so the output
+        // only depends on these settings and can be shared. False with context takeover.
+        bool getSharedCompressionSettings(uint8_t& windowBits, int& compressionLevel) const;
+
     private:
         std::unique_ptr<WebSocketPerMessageDeflateCompressor> _compressor;
         std::unique_ptr<WebSocketPerMessageDeflateDecompressor> _decompressor;
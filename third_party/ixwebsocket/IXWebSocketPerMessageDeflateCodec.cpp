@@ -24,6 +24,11 @@ namespace ix
     // Compressor
     //
     WebSocketPerMessageDeflateCompressor::WebSocketPerMessageDeflateCompressor()
+        : _flush(0)
+        , _deflateBits(15)
+        , _compressionLevel(-1)
+        , _noContextTakeover(false)
+        , _initialized(false)
     {
 #ifdef IXWEBSOCKET_USE_ZLIB
         memset(&_deflateState, 0, sizeof(_deflateState));
@@ -37,26 +42,53 @@ namespace ix
     WebSocketPerMessageDeflateCompressor::~WebSocketPerMessageDeflateCompressor()
     {
 #ifdef IXWEBSOCKET_USE_ZLIB
-        deflateEnd(&_deflateState);
+        if (_initialized) deflateEnd(&_deflateState);
 #endif
     }
 
     bool WebSocketPerMessageDeflateCompressor::init(uint8_t deflateBits,
-                                                    bool clientNoContextTakeOver)
+                                                    bool clientNoContextTakeOver,
+                                                    int compressionLevel)
+    {
+#ifdef IXWEBSOCKET_USE_ZLIB
+        _deflateBits = deflateBits;
+        _compressionLevel = compressionLevel;
+        _noContextTakeover = clientNoContextTakeOver;
+        _flush = (clientNoContextTakeOver) ? Z_FULL_FLUSH : Z_SYNC_FLUSH;
+
+        if (_initialized)
+        {
+            deflateEnd(&_deflateState);
+            _initialized = false;
+        }
+
+        // Validate the parameters now, the state itself is created when needed
+        if (!reset()) return false;
+
+        if (_noContextTakeover)
+        {
+            deflateEnd(&_deflateState);
+            _initialized = false;
+        }
+
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    bool WebSocketPerMessageDeflateCompressor::reset()
     {
 #ifdef IXWEBSOCKET_USE_ZLIB
         int ret = deflateInit2(&_deflateState,
-                               Z_DEFAULT_COMPRESSION,
+                               _compressionLevel,
                                Z_DEFLATED,
-                               -1 * deflateBits,
+                               -1 * _deflateBits,
                                4, // memory level 1-9
                                Z_DEFAULT_STRATEGY);
 
-        if (ret != Z_OK) return false;
-
-        _flush = (clientNoContextTakeOver) ? Z_FULL_FLUSH : Z_SYNC_FLUSH;
-
-        return true;
+        _initialized = (ret == Z_OK);
+        return _initialized;
 #else
         return false;
 #endif
@@ -140,6 +172,8 @@ namespace ix
             return true;
         }
 
+        if (!_initialized && !reset()) return false;
+
         _deflateState.avail_in = (uInt) in.size();
         _deflateState.next_in = (Bytef*) in.data();
 
@@ -161,6 +195,13 @@ namespace ix
             out.resize(out.size() - 4);
         }
 
+        // The window is never reused, so don't keep ~256KB of zlib state per connection
+        if (_noContextTakeover)
+        {
+            deflateEnd(&_deflateState);
+            _initialized = false;
+        }
+
         return true;
 #else
         return false;
@@ -171,6 +212,10 @@ namespace ix
     // Decompressor
     //
     WebSocketPerMessageDeflateDecompressor::WebSocketPerMessageDeflateDecompressor()
+        : _flush(0)
+        , _inflateBits(15)
+        , _noContextTakeover(false)
+        , _initialized(false)
     {
 #ifdef IXWEBSOCKET_USE_ZLIB
         memset(&_inflateState, 0, sizeof(_inflateState));
@@ -186,7 +231,7 @@ namespace ix
     WebSocketPerMessageDeflateDecompressor::~WebSocketPerMessageDeflateDecompressor()
     {
 #ifdef IXWEBSOCKET_USE_ZLIB
-        inflateEnd(&_inflateState);
+        if (_initialized) inflateEnd(&_inflateState);
 #endif
     }
 
@@ -194,13 +239,29 @@ namespace ix
                                                       bool clientNoContextTakeOver)
     {
 #ifdef IXWEBSOCKET_USE_ZLIB
-        int ret = inflateInit2(&_inflateState, -1 * inflateBits);
+        _inflateBits = inflateBits;
+        _noContextTakeover = clientNoContextTakeOver;
+        _flush = (clientNoContextTakeOver) ? Z_FULL_FLUSH : Z_SYNC_FLUSH;
 
-        if (ret != Z_OK) return false;
+        if (_initialized)
+        {
+            inflateEnd(&_inflateState);
+            _initialized = false;
+        }
 
-        _flush = (clientNoContextTakeOver) ? Z_FULL_FLUSH : Z_SYNC_FLUSH;
+        return reset();
+#else
+        return false;
+#endif
+    }
 
-        return true;
+    bool WebSocketPerMessageDeflateDecompressor::reset()
+    {
+#ifdef IXWEBSOCKET_USE_ZLIB
+        int ret = inflateInit2(&_inflateState, -1 * _inflateBits);
+
+        _initialized = (ret == Z_OK);
+        return _initialized;
 #else
         return false;
 #endif
@@ -222,6 +283,8 @@ namespace ix
         std::string inFixed(in);
         inFixed += kEmptyUncompressedBlock;
 
+        if (!_initialized && !reset()) return false;
+
         _inflateState.avail_in = (uInt) inFixed.size();
         _inflateState.next_in = (unsigned char*) (const_cast<char*>(inFixed.data()));
 
@@ -244,6 +307,13 @@ namespace ix
                        _compressBuffer.size() - _inflateState.avail_out);
         } while (_inflateState.avail_out == 0);
 
+        // inflate allocates its window lazily, release it when the peer never reuses it
+        if (_noContextTakeover)
+        {
+            inflateEnd(&_inflateState);
+            _initialized = false;
+        }
+
         return true;
 #else
         return false;
@@ -23,22 +23,34 @@ namespace ix
         WebSocketPerMessageDeflateCompressor();
         ~WebSocketPerMessageDeflateCompressor();
 
-        bool init(uint8_t deflateBits, bool clientNoContextTakeOver);
+        bool init(uint8_t deflateBits, bool clientNoContextTakeOver, int compressionLevel = -1);
         bool compress(const IXWebSocketSendData& in, std::string& out);
         bool compress(const std::string& in, std::string& out);
         bool compress(const std::string& in, std::vector<uint8_t>& out);
         bool compress(const std::vector<uint8_t>& in, std::string& out);
         bool compress(const std::vector<uint8_t>& in, std::vector<uint8_t>& out);
 
+        bool hasContextTakeover() const { return !_noContextTakeover; }
+        uint8_t getDeflateBits() const { return _deflateBits; }
+        int getCompressionLevel() const { return _compressionLevel; }
+
     private:
         template<typename T, typename S>
         bool compressData(const T& in, S& out);
         template<typename T>
         bool endsWithEmptyUnCompressedBlock(const T& value);
 
+        bool reset();
+
         int _flush;
         std::array<unsigned char, 1 << 14> _compressBuffer;
 
+        // Without context takeover the zlib state is only allocated while compressing
+        uint8_t _deflateBits;
+        int _compressionLevel;
+        bool _noContextTakeover;
+        bool _initialized;
+
 #ifdef IXWEBSOCKET_USE_ZLIB
         z_stream _deflateState;
 #endif
@@ -54,9 +66,16 @@ namespace ix
         bool decompress(const std::string& in, std::string& out);
 
     private:
+        bool reset();
+
         int _flush;
         std::array<unsigned char, 1 << 14> _compressBuffer;
 
+        // Without context takeover the zlib state is only allocated while decompressing
+        uint8_t _inflateBits;
+        bool _noContextTakeover;
+        bool _initialized;
+
 #ifdef IXWEBSOCKET_USE_ZLIB
         z_stream _inflateState;
 #endif
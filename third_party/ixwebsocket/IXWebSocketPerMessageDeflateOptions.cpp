@@ -18,6 +18,7 @@ namespace ix
     static const uint8_t maxServerMaxWindowBits = 15;
 
     const uint8_t WebSocketPerMessageDeflateOptions::kDefaultClientMaxWindowBits = 15;
+    const int WebSocketPerMessageDeflateOptions::kDefaultCompressionLevel = -1;
     static const uint8_t minClientMaxWindowBits = 8;
     static const uint8_t maxClientMaxWindowBits = 15;
 
@@ -33,8 +34,13 @@ namespace ix
         _serverNoContextTakeover = serverNoContextTakeover;
         _clientMaxWindowBits = clientMaxWindowBits;
         _serverMaxWindowBits = serverMaxWindowBits;
+        _hasClientMaxWindowBits = true;
+        _hasServerMaxWindowBits = true;
+        _compressionLevel = kDefaultCompressionLevel;
+        _minCompressSize = 0;
 
         sanitizeClientMaxWindowBits();
+        sanitizeServerMaxWindowBits();
     }
 
     //
@@ -60,6 +66,10 @@ namespace ix
         _serverNoContextTakeover = false;
         _clientMaxWindowBits = kDefaultClientMaxWindowBits;
         _serverMaxWindowBits = kDefaultServerMaxWindowBits;
+        _hasClientMaxWindowBits = false;
+        _hasServerMaxWindowBits = false;
+        _compressionLevel = kDefaultCompressionLevel;
+        _minCompressSize = 0;
 
 #ifdef IXWEBSOCKET_USE_ZLIB
         // Split by ;
@@ -88,9 +98,17 @@ namespace ix
                 uint8_t x = strtol(token.substr(token.find_last_of("=") + 1).c_str(), nullptr, 10);
 
                 // Sanitize values to be in the proper range [8, 15] in
-                // case a server would give us bogus values
+                // case a server would give us bogus values. 8 is kept as sent, the
+                // options the engine is set up with raise it.
                 _serverMaxWindowBits =
                     std::min(maxServerMaxWindowBits, std::max(x, minServerMaxWindowBits));
+                _hasServerMaxWindowBits = true;
+            }
+
+            // a client may offer it without a value, to say it supports the parameter
+            if (token == "client_max_window_bits")
+            {
+                _hasClientMaxWindowBits = true;
             }
 
             if (startsWith(token, "client_max_window_bits="))
@@ -101,8 +119,7 @@ namespace ix
                 // case a server would give us bogus values
                 _clientMaxWindowBits =
                     std::min(maxClientMaxWindowBits, std::max(x, minClientMaxWindowBits));
-
-                sanitizeClientMaxWindowBits();
+                _hasClientMaxWindowBits = true;
             }
         }
 #endif
@@ -118,6 +135,65 @@ namespace ix
         }
     }
 
+    void WebSocketPerMessageDeflateOptions::sanitizeServerMaxWindowBits()
+    {
+        // Same zlib limitation, for the window we compress with as a server
+        if (_serverMaxWindowBits == 8)
+        {
+            _serverMaxWindowBits = 9;
+        }
+    }
+
+    void WebSocketPerMessageDeflateOptions::setCompressionLevel(int compressionLevel)
+    {
+        _compressionLevel = std::min(9, std::max(-1, compressionLevel));
+    }
+
+    int WebSocketPerMessageDeflateOptions::getCompressionLevel() const
+    {
+        return _compressionLevel;
+    }
+
+    void WebSocketPerMessageDeflateOptions::setMinCompressSize(size_t minCompressSize)
+    {
+        _minCompressSize = minCompressSize;
+    }
+
+    size_t WebSocketPerMessageDeflateOptions::getMinCompressSize() const
+    {
+        return _minCompressSize;
+    }
+
+    WebSocketPerMessageDeflateOptions WebSocketPerMessageDeflateOptions::negotiate(
+        const WebSocketPerMessageDeflateOptions& offer) const
+    {
+        // We could only answer with a larger window than asked for, zlib cannot compress with 8
+        if (offer._hasServerMaxWindowBits && offer._serverMaxWindowBits < 9)
+        {
+            return WebSocketPerMessageDeflateOptions(false);
+        }
+
+        // Either side asking for no context takeover wins, and a window can only shrink.
+        // The client window may only be limited if the client offered to, and ours is
+        // announced even if not asked for.
+        WebSocketPerMessageDeflateOptions response(
+            offer._enabled,
+            offer._clientNoContextTakeover || _clientNoContextTakeover,
+            offer._serverNoContextTakeover || _serverNoContextTakeover,
+            offer._hasClientMaxWindowBits
+                ? std::min(offer._clientMaxWindowBits, _clientMaxWindowBits)
+                : kDefaultClientMaxWindowBits,
+            std::min(offer._serverMaxWindowBits, _serverMaxWindowBits));
+
+        response._hasClientMaxWindowBits = offer._hasClientMaxWindowBits;
+        response._hasServerMaxWindowBits =
+            offer._hasServerMaxWindowBits || _serverMaxWindowBits < kDefaultServerMaxWindowBits;
+        response._compressionLevel = _compressionLevel;
+        response._minCompressSize = _minCompressSize;
+
+        return response;
+    }
+
     std::string WebSocketPerMessageDeflateOptions::generateHeader()
     {
 #ifdef IXWEBSOCKET_USE_ZLIB
@@ -127,8 +203,14 @@ namespace ix
         if (_clientNoContextTakeover) ss << "; client_no_context_takeover";
         if (_serverNoContextTakeover) ss << "; server_no_context_takeover";
 
-        ss << "; server_max_window_bits=" << static_cast<int>(_serverMaxWindowBits);
-        ss << "; client_max_window_bits=" << static_cast<int>(_clientMaxWindowBits);
+        if (_hasServerMaxWindowBits)
+        {
+            ss << "; server_max_window_bits=" << static_cast<int>(_serverMaxWindowBits);
+        }
+        if (_hasClientMaxWindowBits)
+        {
+            ss << "; client_max_window_bits=" << static_cast<int>(_clientMaxWindowBits);
+        }
 
         ss << "\r\n";
 
@@ -6,6 +6,7 @@
 
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
 #include <string>
 
@@ -30,11 +31,25 @@ namespace ix
         uint8_t getServerMaxWindowBits() const;
         uint8_t getClientMaxWindowBits() const;
 
+        // Local settings, never part of the negotiation
+        void setCompressionLevel(int compressionLevel);
+        int getCompressionLevel() const;
+        // Messages smaller than this are sent uncompressed
+        void setMinCompressSize(size_t minCompressSize);
+        size_t getMinCompressSize() const;
+
+        // Server side: the parameters to answer a client offer with, honoring the
+        // offer while applying our own window and context takeover preferences.
+        // Disabled when the offer cannot be honored.
+        WebSocketPerMessageDeflateOptions negotiate(
+            const WebSocketPerMessageDeflateOptions& offer) const;
+
         static bool startsWith(const std::string& str, const std::string& start);
         static std::string removeSpaces(const std::string& str);
 
         static uint8_t const kDefaultClientMaxWindowBits;
         static uint8_t const kDefaultServerMaxWindowBits;
+        static int const kDefaultCompressionLevel;
 
     private:
         bool _enabled;
@@ -42,7 +57,14 @@ namespace ix
         bool _serverNoContextTakeover;
         uint8_t _clientMaxWindowBits;
         uint8_t _serverMaxWindowBits;
+        // whether the window parameters were part of the parsed header, and are part of
+        // the generated one
+        bool _hasClientMaxWindowBits;
+        bool _hasServerMaxWindowBits;
+        int _compressionLevel;
+        size_t _minCompressSize;
 
         void sanitizeClientMaxWindowBits();
+        void sanitizeServerMaxWindowBits();
     };
 } // namespace ix
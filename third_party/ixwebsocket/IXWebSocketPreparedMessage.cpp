@@ -0,0 +1,103 @@
+/*
+ *  IXWebSocketPreparedMessage.cpp
+ */
+
+#include "IXWebSocketPreparedMessage.h"
+
+#include "IXWebSocketPerMessageDeflateCodec.h"
+
+namespace
+{
+    const uint8_t kFin = 0x80;
+    const uint8_t kRsv1 = 0x40; // set on compressed messages
+    const uint8_t kTextFrame = 0x1;
+    const uint8_t kBinaryFrame = 0x2;
+} // namespace
+
+namespace ix
+{
+    WebSocketPreparedMessage::WebSocketPreparedMessage(std::string payload, bool binary)
+        : _payload(std::move(payload))
+        , _binary(binary)
+    {
+        ;
+    }
+
+    WebSocketPreparedMessage::FramePtr WebSocketPreparedMessage::getFrame() const
+    {
+        std::lock_guard<std::mutex> lock(_framesMutex);
+
+        if (!_frame)
+        {
+            _frame = buildFrame(_payload, false);
+        }
+
+        return _frame;
+    }
+
+    WebSocketPreparedMessage::FramePtr WebSocketPreparedMessage::getCompressedFrame(
+        uint8_t windowBits, int compressionLevel) const
+    {
+        std::lock_guard<std::mutex> lock(_framesMutex);
+
+        for (const auto& compressedFrame : _compressedFrames)
+        {
+            if (compressedFrame.windowBits == windowBits &&
+                compressedFrame.compressionLevel == compressionLevel)
+            {
+                return compressedFrame.frame;
+            }
+        }
+
+        // Same output as a connection compressing without context takeover
+        FramePtr frame;
+        WebSocketPerMessageDeflateCompressor compressor;
+        std::string compressed;
+
+        if (compressor.init(windowBits, true, compressionLevel) &&
+            compressor.compress(_payload, compressed))
+        {
+            frame = buildFrame(compressed, true);
+        }
+
+        _compressedFrames.push_back({windowBits, compressionLevel, frame});
+        return frame;
+    }
+
+    WebSocketPreparedMessage::FramePtr WebSocketPreparedMessage::buildFrame(
+        const std::string& payload, bool compressed) const
+    {
+        auto frame = std::make_shared<Frame>();
+        frame->wireSize = payload.size();
+
+        // A single frame whatever the size, fragmenting only matters to senders that stream
+        uint64_t size = payload.size();
+        std::string& data = frame->data;
+        data.reserve(10 + payload.size());
+
+        data.push_back(static_cast<char>(kFin | (compressed ? kRsv1 : 0) |
+                                         (_binary ? kBinaryFrame : kTextFrame)));
+
+        if (size < 126)
+        {
+            data.push_back(static_cast<char>(size));
+        }
+        else if (size < 65536)
+        {
+            data.push_back(static_cast<char>(126));
+            data.push_back(static_cast<char>((size >> 8) & 0xff));
+            data.push_back(static_cast<char>(size & 0xff));
+        }
+        else
+        {
+            data.push_back(static_cast<char>(127));
+            for (int shift = 56; shift >= 0; shift -= 8)
+            {
+                data.push_back(static_cast<char>((size >> shift) & 0xff));
+            }
+        }
+
+        data.append(payload);
+        return frame;
+    }
+} // namespace ix
@@ -0,0 +1,65 @@
+/*
+ *  IXWebSocketPreparedMessage.h
+ *
+ *  A message that is framed, and compressed where the connection allows it,
+ *  only once, then sent as is to any number of server connections.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace ix
+{
+    class WebSocketPreparedMessage
+    {
+    public:
+        WebSocketPreparedMessage(std::string payload, bool binary);
+
+        const std::string& getPayload() const
+        {
+            return _payload;
+        }
+
+        bool isBinary() const
+        {
+            return _binary;
+        }
+
+        struct Frame
+        {
+            std::string data; // header and payload, unmasked as a server sends them
+            size_t wireSize;  // payload size on the wire, as reported by WebSocketSendInfo
+        };
+        using FramePtr = std::shared_ptr<const Frame>;
+
+        // Frames are built on first use and then shared by every connection
+        FramePtr getFrame() const;
+        // Compressed from a fresh deflate context, nullptr if compression failed
+        FramePtr getCompressedFrame(uint8_t windowBits, int compressionLevel) const;
+
+    private:
+        FramePtr buildFrame(const std::string& payload, bool compressed) const;
+
+        std::string _payload;
+        bool _binary;
+
+        struct CompressedFrame
+        {
+            uint8_t windowBits;
+            int compressionLevel;
+            FramePtr frame;
+        };
+
+        mutable std::mutex _framesMutex;
+        mutable FramePtr _frame;
+        // One per distinct deflate setting among the connections, usually a single one
+        mutable std::vector<CompressedFrame> _compressedFrames;
+    };
+
+    using WebSocketPreparedMessagePtr = std::shared_ptr<const WebSocketPreparedMessage>;
+} // namespace ix
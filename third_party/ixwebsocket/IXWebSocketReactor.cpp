@@ -0,0 +1,502 @@
+/*
+ *  IXWebSocketReactor.cpp
+ */
+
+#include "IXWebSocketReactor.h"
+
+#include "IXSetThreadName.h"
+#include "IXWebSocket.h"
+#include <algorithm>
+
+#ifdef __linux__
+#include <cerrno>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+    // how often a socket is polled while no descriptor can tell us about progress,
+    // e.g. while waiting for the peer to acknowledge a close
+    const int kIdlePollIntervalMs = 10;
+
+    const int kMaxEventsPerWait = 64;
+} // namespace
+
+namespace ix
+{
+    WebSocketReactor::WebSocketReactor()
+        : _epollFd(-1)
+        , _wakeUpFd(-1)
+        , _stop(false)
+        , _size(0)
+    {
+    }
+
+    WebSocketReactor::~WebSocketReactor()
+    {
+        stop();
+    }
+
+    bool WebSocketReactor::isSupported()
+    {
+#ifdef __linux__
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    bool WebSocketReactor::add(WebSocket* webSocket)
+    {
+        if (!ensureStarted()) return false;
+
+        {
+            std::lock_guard<std::mutex> lock(_commandsMutex);
+            _commands.push_back({webSocket, nullptr, nullptr, nullptr});
+        }
+        wakeUp();
+
+        return true;
+    }
+
+    bool WebSocketReactor::adopt(std::shared_ptr<WebSocket> webSocket,
+                                 std::function<void()> onClosed)
+    {
+        if (!ensureStarted()) return false;
+
+        // the loop flushes what the socket does not take right away
+        webSocket->_ws.setBlockingSend(false);
+
+        {
+            std::lock_guard<std::mutex> lock(_commandsMutex);
+            WebSocket* raw = webSocket.get();
+            _commands.push_back({raw, nullptr, std::move(webSocket), std::move(onClosed)});
+        }
+        wakeUp();
+
+        return true;
+    }
+
+    void WebSocketReactor::remove(WebSocket* webSocket)
+    {
+        {
+            std::lock_guard<std::mutex> lock(_startMutex);
+            if (!_thread.joinable()) return;
+        }
+
+        std::promise<void> removed;
+        std::future<void> done = removed.get_future();
+
+        {
+            std::lock_guard<std::mutex> lock(_commandsMutex);
+            _commands.push_back({webSocket, &removed, nullptr, nullptr});
+        }
+        wakeUp();
+
+        done.wait();
+    }
+
+    void WebSocketReactor::stop()
+    {
+        std::lock_guard<std::mutex> lock(_startMutex);
+        if (!_thread.joinable()) return;
+
+        _stop = true;
+        wakeUp();
+        _thread.join();
+
+#ifdef __linux__
+        ::close(_wakeUpFd);
+        ::close(_epollFd);
+#endif
+        _wakeUpFd = -1;
+        _epollFd = -1;
+    }
+
+    size_t WebSocketReactor::size() const
+    {
+        return _size;
+    }
+
+#ifdef __linux__
+    bool WebSocketReactor::ensureStarted()
+    {
+        std::lock_guard<std::mutex> lock(_startMutex);
+        if (_thread.joinable()) return true;
+
+        _epollFd = epoll_create1(EPOLL_CLOEXEC);
+        if (_epollFd < 0) return false;
+
+        _wakeUpFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (_wakeUpFd < 0)
+        {
+            ::close(_epollFd);
+            _epollFd = -1;
+            return false;
+        }
+
+        struct epoll_event event = {};
+        event.events = EPOLLIN;
+        event.data.ptr = nullptr;
+        epoll_ctl(_epollFd, EPOLL_CTL_ADD, _wakeUpFd, &event);
+
+        _stop = false;
+        _thread = std::thread(&WebSocketReactor::run, this);
+
+        return true;
+    }
+
+    void WebSocketReactor::wakeUp()
+    {
+        uint64_t value = 1;
+        if (::write(_wakeUpFd, &value, sizeof(value)) < 0)
+        {
+            // the counter only saturates when the loop is already awake
+        }
+    }
+
+    void WebSocketReactor::run()
+    {
+        setThreadName("WebSocketLoop");
+
+        struct epoll_event events[kMaxEventsPerWait];
+
+        while (!_stop)
+        {
+            Clock::time_point next = Clock::time_point::max();
+            for (auto& it : _entries)
+            {
+                next = std::min(next, it.second->deadline);
+            }
+
+            int timeoutMs = -1;
+            if (next != Clock::time_point::max())
+            {
+                auto delay = std::chrono::ceil<std::chrono::milliseconds>(next - Clock::now());
+                timeoutMs = (int) std::max<int64_t>(0, delay.count());
+            }
+
+            int count = epoll_wait(_epollFd, events, kMaxEventsPerWait, timeoutMs);
+            if (count < 0)
+            {
+                if (errno != EINTR) break;
+                count = 0;
+            }
+
+            processCommands();
+
+            for (int i = 0; i < count; ++i)
+            {
+                Entry* entry = static_cast<Entry*>(events[i].data.ptr);
+                if (entry && !entry->finished) step(*entry);
+            }
+
+            Clock::time_point now = Clock::now();
+            for (auto& it : _entries)
+            {
+                Entry& entry = *it.second;
+                if (entry.finished) continue;
+
+                if (entry.deadline <= now || (entry.state == State::Connecting && entry.connectDone))
+                {
+                    step(entry);
+                }
+            }
+
+            // events from the next wait can no longer point at these
+            for (auto it = _entries.begin(); it != _entries.end();)
+            {
+                if (it->second->finished)
+                    it = _entries.erase(it);
+                else
+                    ++it;
+            }
+        }
+
+        // stop() is only reached once every socket was removed, this is just a safety net
+        for (auto& it : _entries)
+        {
+            Entry& entry = *it.second;
+            if (entry.connector.joinable()) entry.connector.join();
+            if (!entry.finished) finish(entry);
+        }
+        _entries.clear();
+    }
+
+    void WebSocketReactor::processCommands()
+    {
+        uint64_t value;
+        while (::read(_wakeUpFd, &value, sizeof(value)) > 0)
+        {
+        }
+
+        std::vector<Command> commands;
+        {
+            std::lock_guard<std::mutex> lock(_commandsMutex);
+            commands.swap(_commands);
+        }
+
+        for (Command& command : commands)
+        {
+            auto it = _entries.find(command.webSocket);
+
+            if (!command.removed)
+            {
+                Entry* entry;
+                if (it == _entries.end())
+                {
+                    auto created = std::unique_ptr<Entry>(new Entry());
+                    entry = created.get();
+                    _entries.emplace(command.webSocket, std::move(created));
+                }
+                else if (it->second->finished)
+                {
+                    // restarted before the old entry was swept, reuse it
+                    entry = it->second.get();
+                    entry->finished = false;
+                    entry->firstConnectionAttempt = true;
+                    entry->retries = 0;
+                }
+                else
+                {
+                    continue; // already running
+                }
+
+                entry->webSocket = command.webSocket;
+                entry->state = State::Idle;
+                entry->deadline = Clock::time_point::max();
+                _size++;
+
+                if (command.owner)
+                {
+                    // already open, and never reconnected once closed
+                    entry->owner = std::move(command.owner);
+                    entry->onClosed = std::move(command.onClosed);
+                    entry->firstConnectionAttempt = false;
+                    entry->state = State::Open;
+                    watch(*entry);
+                }
+
+                step(*entry);
+            }
+            else if (it == _entries.end() || it->second->finished)
+            {
+                command.removed->set_value();
+            }
+            else
+            {
+                it->second->removed.push_back(command.removed);
+                step(*it->second);
+            }
+        }
+    }
+
+    void WebSocketReactor::step(Entry& entry)
+    {
+        WebSocket& webSocket = *entry.webSocket;
+
+        switch (entry.state)
+        {
+            case State::Idle:
+            {
+                if (webSocket._stop)
+                {
+                    finish(entry);
+                    return;
+                }
+
+                if (!entry.firstConnectionAttempt && !webSocket._automaticReconnection)
+                {
+                    // Do not attempt to reconnect
+                    finish(entry);
+                    return;
+                }
+
+                entry.firstConnectionAttempt = false;
+                connect(entry);
+                return;
+            }
+
+            case State::Waiting:
+            {
+                if (webSocket._stop)
+                {
+                    finish(entry);
+                }
+                else if (entry.deadline <= Clock::now())
+                {
+                    connect(entry);
+                }
+                return;
+            }
+
+            case State::Connecting:
+            {
+                if (!entry.connectDone) return;
+
+                entry.connector.join();
+                entry.deadline = Clock::time_point::max();
+
+                if (entry.connectResult.success)
+                {
+                    entry.retries = 0;
+                    entry.state = State::Open;
+                    watch(entry);
+                    break;
+                }
+
+                double waitMs = webSocket.reportConnectionError(entry.connectResult, entry.retries);
+
+                if (webSocket._stop || !webSocket._automaticReconnection)
+                {
+                    finish(entry);
+                    return;
+                }
+
+                entry.state = State::Waiting;
+                entry.deadline =
+                    Clock::now() + std::chrono::milliseconds(std::max<int64_t>(1, (int64_t) waitMs));
+                return;
+            }
+
+            case State::Open: break;
+        }
+
+        // We can avoid to poll if we want to stop and are not closing
+        if (webSocket._stop && !webSocket.isClosing())
+        {
+            finish(entry);
+            return;
+        }
+
+        webSocket.pollOnce(false);
+
+        if (webSocket.getReadyState() == ReadyState::Closed)
+        {
+            unwatch(entry);
+            entry.state = State::Idle;
+            entry.deadline = Clock::time_point::max();
+            step(entry);
+            return;
+        }
+
+        watchWrite(entry, webSocket._ws.hasPendingSend());
+
+        int timeoutMs = webSocket._ws.getPollTimeout();
+        if (timeoutMs < 0)
+        {
+            entry.deadline = Clock::time_point::max();
+        }
+        else
+        {
+            if (timeoutMs == 0) timeoutMs = kIdlePollIntervalMs;
+            entry.deadline = Clock::now() + std::chrono::milliseconds(timeoutMs);
+        }
+    }
+
+    void WebSocketReactor::connect(Entry& entry)
+    {
+        entry.state = State::Connecting;
+        entry.deadline = Clock::time_point::max();
+        entry.connectDone = false;
+
+        entry.connector = std::thread(
+            [this, &entry]
+            {
+                entry.connectResult = entry.webSocket->connect(entry.webSocket->_handshakeTimeoutSecs);
+                entry.connectDone = true;
+                wakeUp();
+            });
+    }
+
+    void WebSocketReactor::watch(Entry& entry)
+    {
+        int sockfd, wakeUpFd;
+        entry.webSocket->_ws.getPollFds(sockfd, wakeUpFd);
+
+        for (int fd : {sockfd, wakeUpFd})
+        {
+            if (fd == -1) continue;
+
+            struct epoll_event event = {};
+            event.events = EPOLLIN;
+            event.data.ptr = &entry;
+            if (epoll_ctl(_epollFd, EPOLL_CTL_ADD, fd, &event) < 0 && errno == EEXIST)
+            {
+                epoll_ctl(_epollFd, EPOLL_CTL_MOD, fd, &event);
+            }
+        }
+
+        entry.sockFd = sockfd;
+        entry.wakeUpFd = wakeUpFd;
+        entry.watchingWrite = false;
+    }
+
+    void WebSocketReactor::watchWrite(Entry& entry, bool enable)
+    {
+        if (entry.watchingWrite == enable || entry.sockFd == -1) return;
+
+        struct epoll_event event = {};
+        event.events = enable ? (EPOLLIN | EPOLLOUT) : EPOLLIN;
+        event.data.ptr = &entry;
+        epoll_ctl(_epollFd, EPOLL_CTL_MOD, entry.sockFd, &event);
+
+        entry.watchingWrite = enable;
+    }
+
+    void WebSocketReactor::unwatch(Entry& entry)
+    {
+        int sockfd, wakeUpFd;
+        entry.webSocket->_ws.getPollFds(sockfd, wakeUpFd);
+
+        // a closed socket already left the epoll set on its own, and its number may
+        // have been handed out again, so only remove descriptors that are still ours
+        if (entry.sockFd != -1 && entry.sockFd == sockfd)
+        {
+            epoll_ctl(_epollFd, EPOLL_CTL_DEL, entry.sockFd, nullptr);
+        }
+        if (entry.wakeUpFd != -1 && entry.wakeUpFd == wakeUpFd)
+        {
+            epoll_ctl(_epollFd, EPOLL_CTL_DEL, entry.wakeUpFd, nullptr);
+        }
+
+        entry.sockFd = -1;
+        entry.wakeUpFd = -1;
+        entry.watchingWrite = false;
+    }
+
+    void WebSocketReactor::finish(Entry& entry)
+    {
+        if (entry.state == State::Open) unwatch(entry);
+
+        entry.finished = true;
+        entry.state = State::Idle;
+        entry.deadline = Clock::time_point::max();
+        _size--;
+
+        for (std::promise<void>* removed : entry.removed)
+        {
+            removed->set_value();
+        }
+        entry.removed.clear();
+
+        // the owner is only released when the entry is swept, after this loop iteration
+        if (entry.onClosed)
+        {
+            entry.onClosed();
+            entry.onClosed = nullptr;
+        }
+    }
+#else
+    bool WebSocketReactor::ensureStarted()
+    {
+        return false;
+    }
+
+    void WebSocketReactor::wakeUp()
+    {
+    }
+#endif
+} // namespace ix
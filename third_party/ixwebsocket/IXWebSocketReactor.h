@@ -0,0 +1,123 @@
+/*
+ *  IXWebSocketReactor.h
+ *
+ *  Shared event loop driving many WebSockets from one thread.
+ *
+ *  Every attached socket is watched with epoll, along with the wake up pipe
+ *  its sends and closes signal, and for writability while sends are queued.
+ *  Connecting (DNS, TCP, TLS and the HTTP upgrade) stays blocking, so each
+ *  client attempt runs on a short lived helper thread and hands the socket
+ *  back once it is open. Server sockets are handed over already open. Only
+ *  available on Linux, elsewhere add() refuses and the socket keeps its own
+ *  thread.
+ */
+
+#pragma once
+
+#include "IXWebSocketInitResult.h"
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace ix
+{
+    class WebSocket;
+
+    class WebSocketReactor
+    {
+    public:
+        WebSocketReactor();
+        ~WebSocketReactor();
+
+        WebSocketReactor(const WebSocketReactor&) = delete;
+        WebSocketReactor& operator=(const WebSocketReactor&) = delete;
+
+        static bool isSupported();
+
+        // Called by WebSocket::start / WebSocket::stop, remove blocks until
+        // the reactor no longer touches the socket
+        bool add(WebSocket* webSocket);
+        void remove(WebSocket* webSocket);
+
+        // Drives a server side socket whose handshake is done, until it closes. The
+        // reactor keeps it alive until then, onClosed runs on the loop thread.
+        bool adopt(std::shared_ptr<WebSocket> webSocket, std::function<void()> onClosed);
+
+        // Joins the loop thread, every socket must have been removed
+        void stop();
+
+        // Number of sockets currently driven by the loop
+        size_t size() const;
+
+    private:
+        using Clock = std::chrono::steady_clock;
+
+        enum class State
+        {
+            Idle,
+            Waiting,
+            Connecting,
+            Open
+        };
+
+        struct Entry
+        {
+            WebSocket* webSocket;
+            State state = State::Idle;
+            bool firstConnectionAttempt = true;
+            bool finished = false;
+            uint32_t retries = 0;
+            Clock::time_point deadline = Clock::time_point::max();
+
+            std::thread connector;
+            std::atomic<bool> connectDone {false};
+            WebSocketInitResult connectResult;
+
+            int sockFd = -1;
+            int wakeUpFd = -1;
+            bool watchingWrite = false;
+            std::vector<std::promise<void>*> removed;
+
+            // adopted server sockets
+            std::shared_ptr<WebSocket> owner;
+            std::function<void()> onClosed;
+        };
+
+        struct Command
+        {
+            WebSocket* webSocket;
+            std::promise<void>* removed;
+            std::shared_ptr<WebSocket> owner;
+            std::function<void()> onClosed;
+        };
+
+        bool ensureStarted();
+        void run();
+        void wakeUp();
+        void processCommands();
+        void step(Entry& entry);
+        void connect(Entry& entry);
+        void watch(Entry& entry);
+        void watchWrite(Entry& entry, bool enable);
+        void unwatch(Entry& entry);
+        void finish(Entry& entry);
+
+        int _epollFd;
+        int _wakeUpFd;
+        std::thread _thread;
+        std::atomic<bool> _stop;
+        std::mutex _startMutex;
+
+        std::mutex _commandsMutex;
+        std::vector<Command> _commands;
+
+        std::unordered_map<WebSocket*, std::unique_ptr<Entry>> _entries;
+        std::atomic<size_t> _size;
+    };
+} // namespace ix
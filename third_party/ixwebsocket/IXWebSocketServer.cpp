@@ -9,12 +9,20 @@
 #include "IXNetSystem.h"
 #include "IXSetThreadName.h"
 #include "IXSocketConnect.h"
+#include "IXUniquePtr.h"
 #include "IXWebSocket.h"
 #include "IXWebSocketTransport.h"
+#include <algorithm>
 #include <future>
 #include <sstream>
 #include <string.h>
 
+#ifdef __linux__
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#endif
+
 namespace ix
 {
     const int WebSocketServer::kDefaultHandShakeTimeoutSecs(3); // 3 seconds
@@ -33,6 +41,10 @@ namespace ix
         , _enablePong(kDefaultEnablePong)
         , _enablePerMessageDeflate(true)
         , _pingIntervalSeconds(pingIntervalSeconds)
+        , _handshakeThreadCount(0)
+        , _stopHandshakes(false)
+        , _pendingEpollFd(-1)
+        , _pendingWakeUpFd(-1)
     {
     }
 
@@ -52,6 +64,8 @@ namespace ix
 				} 
 
         SocketServer::stop();
+
+        stopEventLoop();
     }
 
     void WebSocketServer::enablePong()
@@ -69,6 +83,19 @@ namespace ix
         _enablePerMessageDeflate = false;
     }
 
+    void WebSocketServer::setPerMessageDeflateOptions(
+        const WebSocketPerMessageDeflateOptions& options)
+    {
+        std::lock_guard<std::mutex> lock(_perMessageDeflateOptionsMutex);
+        _perMessageDeflateOptions = options;
+    }
+
+    WebSocketPerMessageDeflateOptions WebSocketServer::getPerMessageDeflateOptions()
+    {
+        std::lock_guard<std::mutex> lock(_perMessageDeflateOptionsMutex);
+        return _perMessageDeflateOptions;
+    }
+
     void WebSocketServer::setOnConnectionCallback(const OnConnectionCallback& callback)
     {
         _onConnectionCallback = callback;
@@ -93,6 +120,21 @@ namespace ix
     {
         setThreadName("Srv:ws:" + connectionState->getId());
 
+        auto webSocket = openWebSocket(std::move(socket), connectionState, request);
+        if (!webSocket) return;
+
+        // Process incoming messages and execute callbacks
+        // until the connection is closed
+        webSocket->run();
+
+        releaseWebSocket(webSocket);
+    }
+
+    std::shared_ptr<WebSocket> WebSocketServer::openWebSocket(
+        std::unique_ptr<Socket> socket,
+        std::shared_ptr<ConnectionState> connectionState,
+        HttpRequestPtr request)
+    {
         auto webSocket = std::make_shared<WebSocket>();
 
         webSocket->setAutoThreadName(false);
@@ -108,7 +150,7 @@ namespace ix
                          "registered.");
                 logError("Missing call to setOnMessageCallback inside setOnConnectionCallback.");
                 connectionState->setTerminated();
-                return;
+                return nullptr;
             }
         }
         else if (_onClientMessageCallback)
@@ -124,7 +166,7 @@ namespace ix
                 "WebSocketServer Application developer error: No server callback is registerered.");
             logError("Missing call to setOnConnectionCallback or setOnClientMessageCallback.");
             connectionState->setTerminated();
-            return;
+            return nullptr;
         }
 
         webSocket->disableAutomaticReconnection();
@@ -138,6 +180,8 @@ namespace ix
             webSocket->disablePong();
         }
 
+        webSocket->setPerMessageDeflateOptions(getPerMessageDeflateOptions());
+
         // Add this client to our client set
         {
             std::lock_guard<std::mutex> lock(_clientsMutex);
@@ -146,20 +190,22 @@ namespace ix
 
         auto status = webSocket->connectToSocket(
             std::move(socket), _handshakeTimeoutSecs, _enablePerMessageDeflate, request);
-        if (status.success)
-        {
-            // Process incoming messages and execute callbacks
-            // until the connection is closed
-            webSocket->run();
-        }
-        else
+        if (!status.success)
         {
             std::stringstream ss;
             ss << "WebSocketServer::handleConnection() HTTP status: " << status.http_status
                << " error: " << status.errorStr;
             logError(ss.str());
+
+            releaseWebSocket(webSocket);
+            return nullptr;
         }
 
+        return webSocket;
+    }
+
+    void WebSocketServer::releaseWebSocket(const std::shared_ptr<WebSocket>& webSocket)
+    {
         webSocket->setOnMessageCallback(nullptr);
 
         // Remove this client from our client set
@@ -170,6 +216,305 @@ namespace ix
                 logError("Cannot delete client");
             }
         }
+        _clientsCondition.notify_all();
+    }
+
+    bool WebSocketServer::enableEventLoop(size_t loopThreads, size_t handshakeThreads)
+    {
+        // running handshake threads look the loops up, and the accept thread reads the count
+        if (!WebSocketReactor::isSupported() || !loopThreads || !handshakeThreads || isListening())
+        {
+            return false;
+        }
+
+        _reactors.clear();
+        for (size_t i = 0; i < loopThreads; ++i)
+        {
+            _reactors.push_back(ix::make_unique<WebSocketReactor>());
+        }
+        _handshakeThreadCount = handshakeThreads;
+
+        return true;
+    }
+
+    bool WebSocketServer::isEventLoopEnabled() const
+    {
+        return !_reactors.empty();
+    }
+
+    bool WebSocketServer::isAcceptDeferred() const
+    {
+        return !_reactors.empty();
+    }
+
+    void WebSocketServer::dispatchConnection(std::unique_ptr<Socket> socket,
+                                             std::shared_ptr<ConnectionState> connectionState)
+    {
+        if (_reactors.empty())
+        {
+            SocketServer::dispatchConnection(std::move(socket), connectionState);
+            return;
+        }
+
+#ifdef __linux__
+        std::lock_guard<std::mutex> lock(_handshakesMutex);
+
+        if (_handshakeThreads.empty())
+        {
+            _stopHandshakes = false;
+
+            _pendingEpollFd = epoll_create1(EPOLL_CLOEXEC);
+            _pendingWakeUpFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+
+            struct epoll_event event = {};
+            event.events = EPOLLIN;
+            event.data.fd = _pendingWakeUpFd;
+            epoll_ctl(_pendingEpollFd, EPOLL_CTL_ADD, _pendingWakeUpFd, &event);
+
+            _pendingThread = std::thread(&WebSocketServer::runPending, this);
+            for (size_t i = 0; i < _handshakeThreadCount; ++i)
+            {
+                _handshakeThreads.emplace_back(&WebSocketServer::runHandshakes, this);
+            }
+        }
+
+        // the TLS handshake is driven from the pending thread as well, only begun by accept
+        int fd = socket->getFd();
+        struct epoll_event event = {};
+        event.events = EPOLLIN | EPOLLRDHUP;
+        event.data.fd = fd;
+        epoll_ctl(_pendingEpollFd, EPOLL_CTL_ADD, fd, &event);
+
+        auto deadline =
+            std::chrono::steady_clock::now() + std::chrono::seconds(_handshakeTimeoutSecs);
+        _pending[fd] =
+            PendingConnection {std::move(socket), connectionState, deadline, isTLSEnabled()};
+
+        // the wait may need to end sooner
+        uint64_t value = 1;
+        if (::write(_pendingWakeUpFd, &value, sizeof(value)) < 0)
+        {
+            // the counter only saturates when the thread is already awake
+        }
+#endif
+    }
+
+    void WebSocketServer::runPending()
+    {
+#ifdef __linux__
+        setThreadName("Srv:hw:" + std::to_string(getPort()));
+
+        const int kMaxEvents = 64;
+        struct epoll_event events[kMaxEvents];
+
+        for (;;)
+        {
+            int timeoutMs = -1;
+            {
+                std::lock_guard<std::mutex> lock(_handshakesMutex);
+                if (_stopHandshakes) return;
+
+                auto now = std::chrono::steady_clock::now();
+                for (auto& it : _pending)
+                {
+                    auto delay =
+                        std::chrono::ceil<std::chrono::milliseconds>(it.second.deadline - now);
+                    int delayMs = (int) std::max<int64_t>(0, delay.count());
+                    if (timeoutMs < 0 || delayMs < timeoutMs) timeoutMs = delayMs;
+                }
+            }
+
+            int count = epoll_wait(_pendingEpollFd, events, kMaxEvents, timeoutMs);
+
+            std::unique_lock<std::mutex> lock(_handshakesMutex);
+
+            for (int i = 0; i < count; ++i)
+            {
+                int fd = events[i].data.fd;
+                if (fd == _pendingWakeUpFd)
+                {
+                    uint64_t value;
+                    while (::read(_pendingWakeUpFd, &value, sizeof(value)) > 0)
+                    {
+                    }
+                    continue;
+                }
+
+                auto it = _pending.find(fd);
+                if (it == _pending.end()) continue;
+
+                if (it->second.accepting)
+                {
+                    // stepped without the lock, only this thread erases pending connections
+                    Socket& socket = *it->second.socket;
+                    lock.unlock();
+                    std::string errorMsg;
+                    AcceptResult result = socket.acceptStep(errorMsg);
+                    bool buffered = result == AcceptResult::Done && socket.hasBufferedData();
+                    lock.lock();
+
+                    if (result == AcceptResult::Failed)
+                    {
+                        logError("WebSocketServer::runPending() tls accept failed: " + errorMsg);
+                        epoll_ctl(_pendingEpollFd, EPOLL_CTL_DEL, fd, nullptr);
+                        it->second.connectionState->setTerminated();
+                        _pending.erase(it);
+                        continue;
+                    }
+
+                    // TLS may already hold the request in its buffers, where epoll cannot see it
+                    if (!buffered)
+                    {
+                        it->second.accepting = result != AcceptResult::Done;
+
+                        struct epoll_event event = {};
+                        event.events = EPOLLIN | EPOLLRDHUP;
+                        if (result == AcceptResult::WantWrite) event.events |= EPOLLOUT;
+                        event.data.fd = fd;
+                        epoll_ctl(_pendingEpollFd, EPOLL_CTL_MOD, fd, &event);
+                        continue;
+                    }
+                }
+
+                // the request arrived, or the peer went away and the handshake fails fast
+                epoll_ctl(_pendingEpollFd, EPOLL_CTL_DEL, fd, nullptr);
+                _handshakes.emplace_back(std::move(it->second.socket),
+                                         std::move(it->second.connectionState));
+                _pending.erase(it);
+                _handshakesCondition.notify_one();
+            }
+
+            auto now = std::chrono::steady_clock::now();
+            for (auto it = _pending.begin(); it != _pending.end();)
+            {
+                if (it->second.deadline > now)
+                {
+                    ++it;
+                    continue;
+                }
+
+                epoll_ctl(_pendingEpollFd, EPOLL_CTL_DEL, it->first, nullptr);
+                it->second.connectionState->setTerminated();
+                it = _pending.erase(it);
+            }
+        }
+#endif
+    }
+
+    void WebSocketServer::runHandshakes()
+    {
+        setThreadName("Srv:hs:" + std::to_string(getPort()));
+
+        for (;;)
+        {
+            std::unique_ptr<Socket> socket;
+            std::shared_ptr<ConnectionState> connectionState;
+            {
+                std::unique_lock<std::mutex> lock(_handshakesMutex);
+                _handshakesCondition.wait(
+                    lock, [this] { return _stopHandshakes || !_handshakes.empty(); });
+
+                if (_stopHandshakes) return;
+
+                socket = std::move(_handshakes.front().first);
+                connectionState = std::move(_handshakes.front().second);
+                _handshakes.pop_front();
+            }
+
+            auto webSocket = openWebSocket(std::move(socket), connectionState, nullptr);
+            if (!webSocket)
+            {
+                connectionState->setTerminated();
+                continue;
+            }
+
+            // the loop driving the fewest connections
+            auto reactor = std::min_element(
+                _reactors.begin(),
+                _reactors.end(),
+                [](const std::unique_ptr<WebSocketReactor>& a,
+                   const std::unique_ptr<WebSocketReactor>& b) { return a->size() < b->size(); });
+
+            // onClosed is dropped once called, so capturing the socket does not keep it alive
+            bool adopted = (*reactor)->adopt(webSocket,
+                                             [this, webSocket, connectionState]
+                                             {
+                                                 releaseWebSocket(webSocket);
+                                                 connectionState->setTerminated();
+                                             });
+            if (!adopted)
+            {
+                logError("WebSocketServer::runHandshakes() cannot start the event loop");
+                webSocket->close();
+                releaseWebSocket(webSocket);
+                connectionState->setTerminated();
+            }
+        }
+    }
+
+    void WebSocketServer::stopEventLoop()
+    {
+#ifdef __linux__
+        // the accept thread is gone, so nothing is queued anymore
+        {
+            std::lock_guard<std::mutex> lock(_handshakesMutex);
+            _stopHandshakes = true;
+
+            if (_pendingWakeUpFd != -1)
+            {
+                uint64_t value = 1;
+                if (::write(_pendingWakeUpFd, &value, sizeof(value)) < 0)
+                {
+                }
+            }
+        }
+        _handshakesCondition.notify_all();
+
+        if (_pendingThread.joinable()) _pendingThread.join();
+        for (auto& thread : _handshakeThreads)
+        {
+            thread.join();
+        }
+        _handshakeThreads.clear();
+
+        for (auto& handshake : _handshakes)
+        {
+            handshake.second->setTerminated();
+        }
+        _handshakes.clear();
+
+        for (auto& it : _pending)
+        {
+            it.second.connectionState->setTerminated();
+        }
+        _pending.clear();
+
+        if (_pendingEpollFd != -1)
+        {
+            ::close(_pendingWakeUpFd);
+            ::close(_pendingEpollFd);
+            _pendingWakeUpFd = -1;
+            _pendingEpollFd = -1;
+        }
+#endif
+
+        if (_reactors.empty()) return;
+
+        // close what the handshake threads opened meanwhile, and wait for the loops to let go
+        for (auto& client : getClients())
+        {
+            client.first->close();
+        }
+
+        {
+            std::unique_lock<std::mutex> lock(_clientsMutex);
+            _clientsCondition.wait(lock, [this] { return _clients.empty(); });
+        }
+
+        for (auto& reactor : _reactors)
+        {
+            reactor->stop();
+        }
     }
 		
     std::map<std::shared_ptr<WebSocket>, const std::string> WebSocketServer::getClients()
@@ -180,8 +525,15 @@ namespace ix
 
     size_t WebSocketServer::getConnectedClientsCount()
     {
+        // connections waiting for a handshake thread count as well
+        size_t pending;
+        {
+            std::lock_guard<std::mutex> lock(_handshakesMutex);
+            pending = _handshakes.size() + _pending.size();
+        }
+
         std::lock_guard<std::mutex> lock(_clientsMutex);
-        return _clients.size();
+        return _clients.size() + pending;
     }
 
     //
@@ -8,8 +8,12 @@
 
 #include "IXSocketServer.h"
 #include "IXWebSocket.h"
+#include "IXWebSocketReactor.h"
+#include <chrono>
 #include <condition_variable>
+#include <deque>
 #include <functional>
+#include <map>
 #include <memory>
 #include <mutex>
 #include <set>
@@ -41,6 +45,10 @@ namespace ix
         void enablePong();
         void disablePong();
         void disablePerMessageDeflate();
+        // Window and context takeover limits applied to client offers, and local
+        // compression settings for every new connection
+        void setPerMessageDeflateOptions(const WebSocketPerMessageDeflateOptions& options);
+        WebSocketPerMessageDeflateOptions getPerMessageDeflateOptions();
 
         void setOnConnectionCallback(const OnConnectionCallback& callback);
         void setOnClientMessageCallback(const OnClientMessageCallback& callback);
@@ -57,6 +65,12 @@ namespace ix
         bool isPongEnabled();
         bool isPerMessageDeflateEnabled();
 
+        // Serves open connections from loopThreads epoll loops instead of a thread each,
+        // handshakes run on handshakeThreads workers once the request has arrived, after
+        // the TLS handshake is done without blocking. Linux only, refused while listening.
+        bool enableEventLoop(size_t loopThreads, size_t handshakeThreads = 2);
+        bool isEventLoopEnabled() const;
+
     private:
         // Member variables
         int _handshakeTimeoutSecs;
@@ -64,12 +78,42 @@ namespace ix
         bool _enablePerMessageDeflate;
         int _pingIntervalSeconds;
 
+        std::mutex _perMessageDeflateOptionsMutex;
+        WebSocketPerMessageDeflateOptions _perMessageDeflateOptions;
+
         OnConnectionCallback _onConnectionCallback;
         OnClientMessageCallback _onClientMessageCallback;
 
         std::mutex _clientsMutex;
         //std::set<std::shared_ptr<WebSocket>> _clients;
 				std::map<std::shared_ptr<WebSocket>, const std::string> _clients;
+        // signalled whenever a client is removed, stop() waits for the event loops to drain
+        std::condition_variable _clientsCondition;
+
+        // event loop mode
+        std::vector<std::unique_ptr<WebSocketReactor>> _reactors;
+        size_t _handshakeThreadCount;
+        std::vector<std::thread> _handshakeThreads;
+        std::deque<std::pair<std::unique_ptr<Socket>, std::shared_ptr<ConnectionState>>>
+            _handshakes;
+        std::mutex _handshakesMutex;
+        std::condition_variable _handshakesCondition;
+        bool _stopHandshakes;
+
+        // Connections whose upgrade request has not arrived yet, so that handshake
+        // threads never wait on slow clients. Keyed by descriptor.
+        struct PendingConnection
+        {
+            std::unique_ptr<Socket> socket;
+            std::shared_ptr<ConnectionState> connectionState;
+            std::chrono::steady_clock::time_point deadline;
+            // the TLS handshake is still running
+            bool accepting;
+        };
+        std::map<int, PendingConnection> _pending;
+        std::thread _pendingThread;
+        int _pendingEpollFd;
+        int _pendingWakeUpFd;
 
         const static bool kDefaultEnablePong;
         const static int kPingIntervalSeconds;
@@ -78,6 +122,19 @@ namespace ix
         virtual void handleConnection(std::unique_ptr<Socket> socket,
                                       std::shared_ptr<ConnectionState> connectionState);
         virtual size_t getConnectedClientsCount() final;
+        virtual void dispatchConnection(std::unique_ptr<Socket> socket,
+                                        std::shared_ptr<ConnectionState> connectionState) override;
+        virtual bool isAcceptDeferred() const override;
+
+        // Runs the handshake, returns the open socket or nullptr
+        std::shared_ptr<WebSocket> openWebSocket(std::unique_ptr<Socket> socket,
+                                                 std::shared_ptr<ConnectionState> connectionState,
+                                                 HttpRequestPtr request);
+        void releaseWebSocket(const std::shared_ptr<WebSocket>& webSocket);
+
+        void runHandshakes();
+        void runPending();
+        void stopEventLoop();
 
     protected:
         void handleUpgrade(std::unique_ptr<Socket> socket,
@@ -67,6 +67,7 @@ namespace ix
         , _closeWireSize(0)
         , _closeRemote(false)
         , _enablePerMessageDeflate(false)
+        , _minCompressSize(0)
         , _requestInitCancellation(false)
         , _closingTimePoint(std::chrono::steady_clock::now())
         , _enablePong(kDefaultEnablePong)
@@ -77,6 +78,8 @@ namespace ix
         , _pingType(SendMessageKind::Ping)
         , _pingCount(0)
         , _lastSendPingTimePoint(std::chrono::steady_clock::now())
+        , _awaitingHeartBeatPong(false)
+        , _pingRtt(-1)
     {
         setCloseReason(WebSocketCloseConstants::kInternalErrorMessage);
         _readbuf.resize(kChunkSize);
@@ -95,6 +98,7 @@ namespace ix
     {
         _perMessageDeflateOptions = perMessageDeflateOptions;
         _enablePerMessageDeflate = _perMessageDeflateOptions.enabled();
+        _minCompressSize = _perMessageDeflateOptions.getMinCompressSize();
         _socketTLSOptions = socketTLSOptions;
         _enablePong = enablePong;
         _pingIntervalSecs = pingIntervalSecs;
@@ -238,6 +242,7 @@ namespace ix
         {
             std::lock_guard<std::mutex> lock(_lastSendPingTimePointMutex);
             _lastSendPingTimePoint = std::chrono::steady_clock::now();
+            _awaitingHeartBeatPong = false;
         }
     }
 
@@ -271,7 +276,14 @@ namespace ix
         }
         if (pingMessage == SendMessageKind::Ping)
         {
-            return sendPing(ss.str());
+            WebSocketSendInfo info = sendPing(ss.str());
+            if (info.success)
+            {
+                std::lock_guard<std::mutex> lck(_lastSendPingTimePointMutex);
+                _heartBeatPingTimePoint = std::chrono::steady_clock::now();
+                _awaitingHeartBeatPong = true;
+            }
+            return info;
         }
         else if (pingMessage == SendMessageKind::Binary)
         {
@@ -305,7 +317,7 @@ namespace ix
         return now - _closingTimePoint > std::chrono::milliseconds(kClosingMaximumWaitingDelayInMs);
     }
 
-    WebSocketTransport::PollResult WebSocketTransport::poll()
+    WebSocketTransport::PollResult WebSocketTransport::poll(bool block)
     {
         if (_readyState == ReadyState::OPEN)
         {
@@ -326,32 +338,7 @@ namespace ix
             }
         }
 
-        // No timeout if state is not OPEN, otherwise computed
-        // pingIntervalOrTimeoutGCD (equals to -1 if no ping and no ping timeout are set)
-        int lastingTimeoutDelayInMs = (_readyState != ReadyState::OPEN) ? 0 : _pingIntervalSecs;
-
-        if (_pingIntervalSecs > 0)
-        {
-            // compute lasting delay to wait for next ping / timeout, if at least one set
-            auto now = std::chrono::steady_clock::now();
-            int timeSinceLastPingMs = (int) std::chrono::duration_cast<std::chrono::milliseconds>(
-                                          now - _lastSendPingTimePoint)
-                                          .count();
-            lastingTimeoutDelayInMs = (1000 * _pingIntervalSecs) - timeSinceLastPingMs;
-        }
-
-        // The platform may not have select interrupt capabilities, so wait with a small timeout
-        if (lastingTimeoutDelayInMs <= 0 && !_socket->isWakeUpFromPollSupported())
-        {
-            lastingTimeoutDelayInMs = 20;
-        }
-
-        // If we are requesting a cancellation, pass in a positive and small timeout
-        // to never poll forever without a timeout.
-        if (_requestInitCancellation)
-        {
-            lastingTimeoutDelayInMs = 100;
-        }
+        int lastingTimeoutDelayInMs = block ? getPollTimeout() : 0;
 
         // poll the socket
         PollResultType pollResult = _socket->isReadyToRead(lastingTimeoutDelayInMs);
@@ -360,7 +347,7 @@ namespace ix
         // there can be a lot of it for large messages.
         if (pollResult == PollResultType::SendRequest)
         {
-            if (!flushSendBuffer())
+            if (block && !flushSendBuffer())
             {
                 return PollResult::CannotFlushSendBuffer;
             }
@@ -381,6 +368,12 @@ namespace ix
             closeSocket();
         }
 
+        // Write what the socket takes now, the event loop calls again once it is writable
+        if (!block && !isSendBufferEmpty() && !sendOnSocket())
+        {
+            return PollResult::CannotFlushSendBuffer;
+        }
+
         if (_readyState == ReadyState::CLOSING && closingDelayExceeded())
         {
             _rxbuf.clear();
@@ -392,12 +385,61 @@ namespace ix
         return PollResult::Succeeded;
     }
 
+    int WebSocketTransport::getPollTimeout()
+    {
+        // No timeout if state is not OPEN, otherwise computed
+        // pingIntervalOrTimeoutGCD (equals to -1 if no ping and no ping timeout are set)
+        int lastingTimeoutDelayInMs = (_readyState != ReadyState::OPEN) ? 0 : _pingIntervalSecs;
+
+        if (_pingIntervalSecs > 0)
+        {
+            // compute lasting delay to wait for next ping / timeout, if at least one set
+            auto now = std::chrono::steady_clock::now();
+            int timeSinceLastPingMs = (int) std::chrono::duration_cast<std::chrono::milliseconds>(
+                                          now - _lastSendPingTimePoint)
+                                          .count();
+            lastingTimeoutDelayInMs = (1000 * _pingIntervalSecs) - timeSinceLastPingMs;
+        }
+
+        // The platform may not have select interrupt capabilities, so wait with a small timeout
+        if (lastingTimeoutDelayInMs <= 0 && !_socket->isWakeUpFromPollSupported())
+        {
+            lastingTimeoutDelayInMs = 20;
+        }
+
+        // If we are requesting a cancellation, pass in a positive and small timeout
+        // to never poll forever without a timeout.
+        if (_requestInitCancellation)
+        {
+            lastingTimeoutDelayInMs = 100;
+        }
+
+        return lastingTimeoutDelayInMs;
+    }
+
+    void WebSocketTransport::getPollFds(int& sockfd, int& wakeUpFd)
+    {
+        std::lock_guard<std::mutex> lock(_socketMutex);
+        sockfd = _socket ? _socket->getFd() : -1;
+        wakeUpFd = _socket ? _socket->getWakeUpFd() : -1;
+    }
+
     bool WebSocketTransport::isSendBufferEmpty() const
     {
         std::lock_guard<std::mutex> lock(_txbufMutex);
         return _txbuf.empty();
     }
 
+    bool WebSocketTransport::hasPendingSend() const
+    {
+        return !isSendBufferEmpty();
+    }
+
+    void WebSocketTransport::setBlockingSend(bool blockingSend)
+    {
+        _blockingSend = blockingSend;
+    }
+
     template<class Iterator>
     void WebSocketTransport::appendToSendBuffer(const std::vector<uint8_t>& header,
                                                 Iterator begin,
@@ -610,8 +652,9 @@ namespace ix
 
                     if (ws.fin)
                     {
+                        std::string mergedChunks = getMergedChunks();
                         emitMessage(_fragmentedMessageKind,
-                                    getMergedChunks(),
+                                    mergedChunks,
                                     _receivedMessageCompressed,
                                     onMessageCallback);
 
@@ -620,7 +663,8 @@ namespace ix
                     }
                     else
                     {
-                        emitMessage(MessageKind::FRAGMENT, std::string(), false, onMessageCallback);
+                        std::string emptyFragment;
+                        emitMessage(MessageKind::FRAGMENT, emptyFragment, false, onMessageCallback);
                     }
                 }
             }
@@ -647,6 +691,16 @@ namespace ix
             else if (ws.opcode == wsheader_type::PONG)
             {
                 _pongReceived = true;
+                {
+                    std::lock_guard<std::mutex> lck(_lastSendPingTimePointMutex);
+                    if (_awaitingHeartBeatPong)
+                    {
+                        _awaitingHeartBeatPong = false;
+                        _pingRtt = (int) std::chrono::duration_cast<std::chrono::milliseconds>(
+                                       std::chrono::steady_clock::now() - _heartBeatPingTimePoint)
+                                       .count();
+                    }
+                }
                 emitMessage(MessageKind::PONG, frameData, false, onMessageCallback);
             }
             else if (ws.opcode == wsheader_type::CLOSE)
@@ -777,7 +831,7 @@ namespace ix
     }
 
     void WebSocketTransport::emitMessage(MessageKind messageKind,
-                                         const std::string& message,
+                                         std::string& message,
                                          bool compressedMessage,
                                          const OnMessageCallback& onMessageCallback)
     {
@@ -823,7 +877,8 @@ namespace ix
     WebSocketSendInfo WebSocketTransport::sendData(wsheader_type::opcode_type type,
                                                    const IXWebSocketSendData& message,
                                                    bool compress,
-                                                   const OnProgressCallback& onProgressCallback)
+                                                   const OnProgressCallback& onProgressCallback,
+                                                   bool flush)
     {
         if (_readyState != ReadyState::OPEN && _readyState != ReadyState::CLOSING)
         {
@@ -926,7 +981,7 @@ namespace ix
             wakeUpFromPoll(SelectInterrupt::kSendRequest);
 
             // FIXME: we should have a timeout when sending large messages: see #131
-            if (_blockingSend && !flushSendBuffer())
+            if (flush && _blockingSend && !flushSendBuffer())
             {
                 success = false;
             }
@@ -1042,16 +1097,99 @@ namespace ix
                                                      const OnProgressCallback& onProgressCallback)
 
     {
-        return sendData(
-            wsheader_type::BINARY_FRAME, message, _enablePerMessageDeflate, onProgressCallback);
+        bool compress = _enablePerMessageDeflate && message.size() >= _minCompressSize;
+        return sendData(wsheader_type::BINARY_FRAME, message, compress, onProgressCallback);
     }
 
     WebSocketSendInfo WebSocketTransport::sendText(const IXWebSocketSendData& message,
                                                    const OnProgressCallback& onProgressCallback)
 
     {
-        return sendData(
-            wsheader_type::TEXT_FRAME, message, _enablePerMessageDeflate, onProgressCallback);
+        bool compress = _enablePerMessageDeflate && message.size() >= _minCompressSize;
+        return sendData(wsheader_type::TEXT_FRAME, message, compress, onProgressCallback);
+    }
+
+    WebSocketSendInfo WebSocketTransport::sendPrepared(const WebSocketPreparedMessage& message)
+    {
+        if (_readyState != ReadyState::OPEN && _readyState != ReadyState::CLOSING)
+        {
+            return WebSocketSendInfo(false);
+        }
+
+        const std::string& payload = message.getPayload();
+        bool compress = _enablePerMessageDeflate && payload.size() >= _minCompressSize;
+
+        WebSocketPreparedMessage::FramePtr frame;
+        uint8_t windowBits;
+        int compressionLevel;
+
+        if (!_useMask && !compress)
+        {
+            frame = message.getFrame();
+        }
+        else if (!_useMask &&
+                 _perMessageDeflate->getSharedCompressionSettings(windowBits, compressionLevel))
+        {
+            frame = message.getCompressedFrame(windowBits, compressionLevel);
+        }
+
+        // A compressor with context takeover has to see every message it sends
+        if (!frame)
+        {
+            auto type = message.isBinary() ? wsheader_type::BINARY_FRAME : wsheader_type::TEXT_FRAME;
+            return sendData(type, payload, compress, nullptr, false);
+        }
+
+        bool success = sendPreparedFrame(frame->data);
+
+        // one slow peer must not hold up the others the message goes to
+        if (success && !isSendBufferEmpty())
+        {
+            wakeUpFromPoll(SelectInterrupt::kSendRequest);
+        }
+
+        return WebSocketSendInfo(success, false, payload.size(), frame->wireSize);
+    }
+
+    bool WebSocketTransport::sendPreparedFrame(const std::string& frame)
+    {
+        std::lock_guard<std::mutex> lock(_txbufMutex);
+
+        // With nothing queued the shared frame goes straight to the socket, only what the
+        // socket did not take is copied into the send buffer
+        size_t offset = 0;
+
+        while (_txbuf.empty() && offset < frame.size())
+        {
+            ssize_t ret = 0;
+            {
+                std::lock_guard<std::mutex> lock(_socketMutex);
+                ret = _socket->send((char*) frame.data() + offset, frame.size() - offset);
+            }
+
+            if (ret < 0 && Socket::isWaitNeeded())
+            {
+                break;
+            }
+            else if (ret <= 0)
+            {
+                closeSocket();
+                if (_readyState != ReadyState::CLOSING)
+                {
+                    setReadyState(ReadyState::CLOSED);
+                }
+                return false;
+            }
+
+            offset += ret;
+        }
+
+        if (offset < frame.size())
+        {
+            _txbuf.insert(_txbuf.end(), frame.begin() + offset, frame.end());
+        }
+
+        return true;
     }
 
     bool WebSocketTransport::sendOnSocket()
@@ -1219,6 +1357,11 @@ namespace ix
         return _txbuf.size();
     }
 
+    int WebSocketTransport::getPingRtt() const
+    {
+        return _pingRtt;
+    }
+
     bool WebSocketTransport::flushSendBuffer()
     {
         while (!isSendBufferEmpty() && !_requestInitCancellation)
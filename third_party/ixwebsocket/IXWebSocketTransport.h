@@ -18,6 +18,7 @@
 #include "IXWebSocketHttpHeaders.h"
 #include "IXWebSocketPerMessageDeflate.h"
 #include "IXWebSocketPerMessageDeflateOptions.h"
+#include "IXWebSocketPreparedMessage.h"
 #include "IXWebSocketSendData.h"
 #include "IXWebSocketSendInfo.h"
 #include <atomic>
@@ -67,8 +68,9 @@ namespace ix
             CannotFlushSendBuffer
         };
 
+        // The message buffer is handed over, the callback may move from it
         using OnMessageCallback =
-            std::function<void(const std::string&, size_t, bool, MessageKind)>;
+            std::function<void(std::string&, size_t, bool, MessageKind)>;
         using OnCloseCallback = std::function<void(uint16_t, const std::string&, size_t, bool)>;
 
         WebSocketTransport();
@@ -90,12 +92,21 @@ namespace ix
                                             bool enablePerMessageDeflate,
                                             HttpRequestPtr request = nullptr);
 
-        PollResult poll();
+        // block is false when an external event loop already saw activity. The loop then
+        // never waits for the peer to drain the send buffer, it watches for writability
+        // itself while hasPendingSend() is true
+        PollResult poll(bool block = true);
+        int getPollTimeout();
+        void getPollFds(int& sockfd, int& wakeUpFd);
+
         WebSocketSendInfo sendBinary(const IXWebSocketSendData& message,
                                      const OnProgressCallback& onProgressCallback);
         WebSocketSendInfo sendText(const IXWebSocketSendData& message,
                                    const OnProgressCallback& onProgressCallback);
         WebSocketSendInfo sendPing(const IXWebSocketSendData& message);
+        // Server side only, clients mask each frame and fall back to a regular send.
+        // Never waits for the socket, the network thread flushes what it did not take.
+        WebSocketSendInfo sendPrepared(const WebSocketPreparedMessage& message);
 
         void close(uint16_t code = WebSocketCloseConstants::kNormalClosureCode,
                    const std::string& reason = WebSocketCloseConstants::kNormalClosureMessage,
@@ -109,6 +120,11 @@ namespace ix
         void setOnCloseCallback(const OnCloseCallback& onCloseCallback);
         void dispatch(PollResult pollResult, const OnMessageCallback& onMessageCallback);
         size_t bufferedAmount() const;
+        bool hasPendingSend() const;
+        // Servers wait for every send to reach the socket, unless an event loop flushes for them
+        void setBlockingSend(bool blockingSend);
+        // Round trip of the last heartbeat ping in milliseconds, -1 until a pong came back
+        int getPingRtt() const;
 
         // set ping heartbeat message
         void setPingMessage(const std::string& message, SendMessageKind pingType);
@@ -197,6 +213,8 @@ namespace ix
         WebSocketPerMessageDeflatePtr _perMessageDeflate;
         WebSocketPerMessageDeflateOptions _perMessageDeflateOptions;
         std::atomic<bool> _enablePerMessageDeflate;
+        // Smaller messages are not worth the deflate overhead
+        std::atomic<size_t> _minCompressSize;
 
         std::string _decompressedMessage;
         std::string _compressedMessage;
@@ -230,6 +248,11 @@ namespace ix
         mutable std::mutex _lastSendPingTimePointMutex;
         std::chrono::time_point<std::chrono::steady_clock> _lastSendPingTimePoint;
 
+        // Guarded by the same mutex, to time the pong answering a heartbeat ping
+        std::chrono::time_point<std::chrono::steady_clock> _heartBeatPingTimePoint;
+        bool _awaitingHeartBeatPong;
+        std::atomic<int> _pingRtt;
+
         // If this function returns true, it is time to send a new ping
         bool pingIntervalExceeded();
         void initTimePointsAfterConnect();
@@ -249,19 +272,23 @@ namespace ix
 
         bool flushSendBuffer();
         bool sendOnSocket();
+        bool sendPreparedFrame(const std::string& frame);
         bool receiveFromSocket();
 
+        // flush false leaves what the socket does not take right away to the network
+        // thread, even when sends are blocking
         WebSocketSendInfo sendData(wsheader_type::opcode_type type,
                                    const IXWebSocketSendData& message,
                                    bool compress,
-                                   const OnProgressCallback& onProgressCallback = nullptr);
+                                   const OnProgressCallback& onProgressCallback = nullptr,
+                                   bool flush = true);
 
         template<class Iterator>
         bool sendFragment(
             wsheader_type::opcode_type type, bool fin, Iterator begin, Iterator end, bool compress);
 
         void emitMessage(MessageKind messageKind,
-                         const std::string& message,
+                         std::string& message,
                          bool compressedMessage,
                          const OnMessageCallback& onMessageCallback);
 